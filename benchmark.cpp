@@ -0,0 +1,369 @@
+#include "src/estimate.hpp"
+#include "src/random.hpp"
+#include "src/qmc.hpp"
+#include "src/detail/quantile.hpp"
+#include <random>
+#include <chrono>
+#include <cmath> // `std::exp`, `std::log`, `std::erfc`, `std::sqrt`
+#include <algorithm> // `std::min`
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Mesure du débit des noyaux de calcul, cf `README.txt`.
+
+struct measurement {
+    std::string kernel, averaging, step, distribution;
+    int N;
+    long long samples; // nombre de tirages de $X$ par exécution
+    int runs; // nombre d'exécutions chronométrées
+    double seconds; // durée moyenne d'une exécution
+    double xi, C; // résultat de la dernière exécution
+};
+
+// Erreur quadratique moyenne sur des exécutions indépendantes, cf `measure_rmse`.
+struct rmse_measurement {
+    std::string kernel, generator, distribution;
+    int N, replicas;
+    double seconds; // durée moyenne d'une exécution
+    double xi_rmse, C_rmse;
+};
+
+struct benchmark_args {
+    int max_N = 10000000;
+    bool json = false;
+    bool rmse = false;
+    int replicas = 16;
+};
+
+auto parse_benchmark_args(int argc, char ** argv) -> benchmark_args {
+    benchmark_args args;
+    for (int i = 1; i < argc; ++i) {
+        auto option = std::string { argv[i] };
+        if (option == "--json") {
+            args.json = true;
+        } else if (option == "--rmse") {
+            args.rmse = true;
+        } else if (option == "--replicas") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--replicas`" };
+            auto value = std::string { argv[i] };
+            try { args.replicas = std::stoi(value); } catch(...) { args.replicas = -1; }
+            if (args.replicas < 2)
+                throw "bad replicas value: " + value;
+        } else if (option == "--max-n") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--max-n`" };
+            auto value = std::string { argv[i] };
+            try { args.max_N = std::stoi(value); } catch(...) { args.max_N = -1; }
+            if (args.max_N < 10000)
+                throw "bad N value: " + value;
+        } else {
+            throw "unknown option: " + option;
+        }
+    }
+    return args;
+}
+
+// Exécute `kernel` au moins une fois et jusqu'à ce que 0.2 seconde se soit écoulée, en
+// repartant à chaque fois du même générateur pour que toutes les exécutions fassent le même
+// travail.
+template<class Kernel, class Distribution>
+auto measure(Kernel kernel, Distribution d, measurement m) -> measurement {
+    using clock = std::chrono::steady_clock;
+    std::pair<double, double> result;
+    auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+    m.runs = 0;
+    do {
+        auto g = philox4x32 { 42 };
+        d.reset();
+        result = kernel.compute(d, g);
+        ++m.runs;
+        elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds { 200 });
+
+    m.seconds = std::chrono::duration<double> { elapsed }.count() / m.runs;
+    m.xi = result.first;
+    m.C = result.second;
+    return m;
+}
+
+// Toutes les combinaisons de noyau et de moyennisation pour une distribution, une fonction de
+// perte, une suite de pas et un nombre d'itérations donnés.
+template<class Phi, class Gamma, class Distribution>
+void measure_kernels(
+    const Phi & phi,
+    const Gamma & gamma,
+    const std::string & step,
+    const Distribution & d,
+    const std::string & distribution,
+    int N,
+    std::vector<measurement> & out
+) {
+    auto alpha = 0.95;
+    for (auto avg : { averaging::no, averaging::yes }) {
+        auto m = measurement { };
+        m.averaging = avg == averaging::yes ? "yes" : "no";
+        m.step = step;
+        m.distribution = distribution;
+        m.N = N;
+
+        m.kernel = "stochastic-gradient";
+        m.samples = N;
+        out.push_back(measure(stochastic_gradient(alpha, N, phi, gamma, avg), d, m));
+
+        // La phase 1 fait `N / 100` tirages supplémentaires.
+        m.kernel = "importance-sampling";
+        m.samples = N + N / 100;
+        out.push_back(measure(importance_sampling(alpha, 1., N, phi, gamma, avg), d, m));
+    }
+}
+
+// Erreur quadratique moyenne de `kernel` par rapport aux valeurs exactes `xi` et `C`, sur
+// `replicas` exécutions avec les générateurs `Generator { 1 }`, `Generator { 2 }`, ...: graines
+// différentes pour `std::mt19937`, brouillages différents pour `qmc::sobol`.
+template<class Generator, class Kernel, class Distribution>
+auto measure_rmse(
+    Kernel kernel,
+    Distribution d,
+    double xi,
+    double C,
+    rmse_measurement m
+) -> rmse_measurement {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    double xi_sum = 0, C_sum = 0;
+    for (int r = 0; r < m.replicas; ++r) {
+        auto g = Generator { static_cast<typename Generator::result_type>(r + 1) };
+        d.reset();
+        auto result = kernel.compute(d, g);
+        xi_sum += (result.first - xi) * (result.first - xi);
+        C_sum += (result.second - C) * (result.second - C);
+    }
+    m.seconds = std::chrono::duration<double> { clock::now() - start }.count() / m.replicas;
+    m.xi_rmse = std::sqrt(xi_sum / m.replicas);
+    m.C_rmse = std::sqrt(C_sum / m.replicas);
+    return m;
+}
+
+// Pour chaque noyau, compare les entrées pseudo-aléatoires (`std::mt19937` et une loi de
+// <random>) et quasi-aléatoires (`qmc::sobol` et la loi correspondante de `src/qmc.hpp`).
+template<class Phi, class Gamma, class Distribution, class QMCDistribution>
+void measure_rmse_kernels(
+    const Phi & phi,
+    const Gamma & gamma,
+    const Distribution & d,
+    const QMCDistribution & qmc_d,
+    const std::string & distribution,
+    double alpha,
+    double xi,
+    double C,
+    int N,
+    int replicas,
+    std::vector<rmse_measurement> & out
+) {
+    auto m = rmse_measurement { };
+    m.distribution = distribution;
+    m.N = N;
+    m.replicas = replicas;
+
+    auto sg = stochastic_gradient(alpha, N, phi, gamma, averaging::yes);
+    m.kernel = "stochastic-gradient";
+    m.generator = "mt19937";
+    out.push_back(measure_rmse<std::mt19937>(sg, d, xi, C, m));
+    m.generator = "sobol";
+    out.push_back(measure_rmse<qmc::sobol>(sg, qmc_d, xi, C, m));
+
+    auto is = importance_sampling(alpha, 1., N, phi, gamma, averaging::yes);
+    m.kernel = "importance-sampling";
+    m.generator = "mt19937";
+    out.push_back(measure_rmse<std::mt19937>(is, d, xi, C, m));
+    m.generator = "sobol";
+    out.push_back(measure_rmse<qmc::sobol>(is, qmc_d, xi, C, m));
+}
+
+// Compare `stochastic-gradient` avec et sans réduction de variance (cf
+// `src/variance_reduction.hpp`), à nombre d'évaluations de $\phi$ égal.
+template<class Phi, class Gamma, class Distribution, class H>
+void measure_rmse_variance_reduction(
+    const Phi & phi,
+    const Gamma & gamma,
+    const Distribution & d,
+    const control_variate<H> & control,
+    const std::string & distribution,
+    double alpha,
+    double xi,
+    double C,
+    int N,
+    int replicas,
+    std::vector<rmse_measurement> & out
+) {
+    auto m = rmse_measurement { };
+    m.generator = "mt19937";
+    m.distribution = distribution;
+    m.N = N;
+    m.replicas = replicas;
+
+    m.kernel = "stochastic-gradient-antithetic";
+    auto antithetic_sg =
+        stochastic_gradient(alpha, N, phi, gamma, averaging::yes, 1, antithetic::yes);
+    out.push_back(measure_rmse<std::mt19937>(antithetic_sg, d, xi, C, m));
+
+    m.kernel = "stochastic-gradient-control";
+    auto control_sg = stochastic_gradient(alpha, N, phi, gamma, control, averaging::yes);
+    out.push_back(measure_rmse<std::mt19937>(control_sg, d, xi, C, m));
+}
+
+void print_rmse_csv(const std::vector<rmse_measurement> & results) {
+    std::cout << "kernel,generator,distribution,N,replicas,seconds,xi_rmse,C_rmse" << std::endl;
+    for (const auto & m : results) {
+        std::cout << m.kernel << "," << m.generator << "," << m.distribution << "," << m.N
+                  << "," << m.replicas << "," << m.seconds << "," << m.xi_rmse << ","
+                  << m.C_rmse << std::endl;
+    }
+}
+
+void print_rmse_json(const std::vector<rmse_measurement> & results) {
+    std::cout << "[" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto & m = results[i];
+        std::cout << "  {\"kernel\": \"" << m.kernel << "\", \"generator\": \"" << m.generator
+                  << "\", \"distribution\": \"" << m.distribution << "\", \"N\": " << m.N
+                  << ", \"replicas\": " << m.replicas << ", \"seconds\": " << m.seconds
+                  << ", \"xi_rmse\": " << m.xi_rmse
+                  << ", \"C_rmse\": " << m.C_rmse << "}"
+                  << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    std::cout << "]" << std::endl;
+}
+
+// Fonction de répartition de la loi normale centrée réduite.
+auto normal_cdf(double x) -> double {
+    return 0.5 * std::erfc(-x / std::sqrt(2.));
+}
+
+void print_csv(const std::vector<measurement> & results) {
+    std::cout << "kernel,averaging,step,distribution,N,runs,seconds,samples_per_second,"
+              << "ns_per_iteration,xi,C" << std::endl;
+    for (const auto & m : results) {
+        std::cout << m.kernel << "," << m.averaging << "," << m.step << "," << m.distribution
+                  << "," << m.N << "," << m.runs << "," << m.seconds << ","
+                  << m.samples / m.seconds << "," << 1e9 * m.seconds / m.samples << ","
+                  << m.xi << "," << m.C << std::endl;
+    }
+}
+
+void print_json(const std::vector<measurement> & results) {
+    std::cout << "[" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto & m = results[i];
+        std::cout << "  {\"kernel\": \"" << m.kernel << "\", \"averaging\": \"" << m.averaging
+                  << "\", \"step\": \"" << m.step << "\", \"distribution\": \""
+                  << m.distribution << "\", \"N\": " << m.N << ", \"runs\": " << m.runs
+                  << ", \"seconds\": " << m.seconds << ", \"samples_per_second\": "
+                  << m.samples / m.seconds << ", \"ns_per_iteration\": "
+                  << 1e9 * m.seconds / m.samples << ", \"xi\": " << m.xi << ", \"C\": "
+                  << m.C << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    std::cout << "]" << std::endl;
+}
+
+auto main(int argc, char ** argv) -> int {
+    benchmark_args args;
+    try {
+        args = parse_benchmark_args(argc, argv);
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
+    }
+
+    // Mêmes modèles que `short_put.cpp` et `exponential_distribution.cpp`.
+    auto normal = std::normal_distribution<> { 0., 1. };
+    auto short_put = [](double x) {
+        auto S = 100 * std::exp((0.05 - 0.2 * 0.2 / 2) + 0.2 * x);
+        auto result = -std::exp(0.05) * 10.7;
+        if (110 < S)
+            return result;
+        return 110 - S + result;
+    };
+    auto exponential = std::exponential_distribution<> { 2. };
+
+    if (args.rmse) {
+        auto alpha = 0.95;
+        auto gamma = steps::fixed_pow<3, 4> { 100. };
+
+        // Valeurs exactes pour `short_put`: la perte décroît avec $x$, donc sa V@R est la perte
+        // au quantile $q = \Phi^{-1}(1 - \alpha)$ et sa CV@R l'espérance conditionnelle
+        // sachant $X \le q$. Le put est exercé pour $x < q_0$, où $S(q_0) = 110$; on utilise
+        // $E[S 1_{X \le y}] = 100 e^{0.05} \Phi(y - 0.2)$.
+        auto q = detail::normal_quantile(1 - alpha);
+        auto q0 = (std::log(1.1) - (0.05 - 0.2 * 0.2 / 2)) / 0.2;
+        auto y = std::min(q, q0);
+        auto put_xi = short_put(q);
+        auto put_tail = 110 * normal_cdf(y) - 100 * std::exp(0.05) * normal_cdf(y - 0.2);
+        auto put_C = put_tail / (1 - alpha) - std::exp(0.05) * 10.7;
+
+        // Valeurs exactes pour la loi exponentielle de paramètre 2, cf
+        // `exponential_distribution.cpp`.
+        auto exp_xi = -std::log(1 - alpha) / 2;
+        auto exp_C = exp_xi + 1. / 2;
+
+        // Variables de contrôle de `short_put.cpp` et `exponential_distribution.cpp`.
+        auto payoff = [](double x) {
+            auto S = 100 * std::exp((0.05 - 0.2 * 0.2 / 2) + 0.2 * x);
+            return 110 < S ? 0. : 110 - S;
+        };
+        auto d1 = (std::log(100. / 110.) + 0.05 + 0.2 * 0.2 / 2) / 0.2;
+        auto put = 110 * normal_cdf(0.2 - d1) - 100 * std::exp(0.05) * normal_cdf(-d1);
+
+        std::vector<rmse_measurement> results;
+        for (long long N = 1024; N <= args.max_N; N *= 4) {
+            measure_rmse_kernels(
+                short_put, gamma, normal, qmc::normal_distribution { 0., 1. }, "normal",
+                alpha, put_xi, put_C, N, args.replicas, results
+            );
+            measure_rmse_kernels(
+                identity, gamma, exponential, qmc::exponential_distribution { 2. },
+                "exponential", alpha, exp_xi, exp_C, N, args.replicas, results
+            );
+            measure_rmse_variance_reduction(
+                short_put, gamma, normal, control(payoff, put), "normal", alpha, put_xi, put_C,
+                N, args.replicas, results
+            );
+            measure_rmse_variance_reduction(
+                identity, gamma, exponential, control(identity, 0.5), "exponential", alpha,
+                exp_xi, exp_C, N, args.replicas, results
+            );
+        }
+        if (args.json)
+            print_rmse_json(results);
+        else
+            print_rmse_csv(results);
+        return 0;
+    }
+
+    // Même suite $n \longmapsto \frac{1}{n^{0.75} + 1}$, avec l'exposant connu à l'exécution
+    // (un `std::pow` par appel) ou à la compilation.
+    auto pow_step = steps::inverse_pow(0.75, 1.);
+    auto fixed_step = steps::fixed_pow<3, 4> { 1. };
+
+    // `N` est un `long long`: `10 N` dépasse `INT_MAX` dès que `--max-n` vaut au moins $10^9$.
+    std::vector<measurement> results;
+    for (long long N = 10000; N <= args.max_N; N *= 10) {
+        measure_kernels(short_put, steps::inverse, "inverse", normal, "normal", N, results);
+        measure_kernels(short_put, pow_step, "inverse_pow", normal, "normal", N, results);
+        measure_kernels(short_put, fixed_step, "fixed_pow", normal, "normal", N, results);
+        measure_kernels(identity, steps::inverse, "inverse", exponential, "exponential", N, results);
+        measure_kernels(identity, pow_step, "inverse_pow", exponential, "exponential", N, results);
+        measure_kernels(identity, fixed_step, "fixed_pow", exponential, "exponential", N, results);
+    }
+
+    if (args.json)
+        print_json(results);
+    else
+        print_csv(results);
+    return 0;
+}
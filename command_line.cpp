@@ -1,8 +1,15 @@
 #include "command_line.hpp"
 #include <string>
+#include <vector>
+#include <random> // `std::random_device`
 
-auto parse_command_line(int argc, char ** argv) -> command_line_args {
+auto parse_command_line(int argc, char ** argv, const std::vector<std::string> & defaults) -> command_line_args {
     command_line_args args;
+    std::vector<std::string> parameters; // paramètres positionnels, `alpha` puis `N`
+
+    // Sans l'option `--seed`, on tire une graine au hasard.
+    std::random_device rd;
+    args.seed = static_cast<std::uint64_t>(rd()) << 32 | rd();
 
     int i = 1;
     // Paramètres de la ligne de commande, cf `README.txt`.
@@ -17,6 +24,8 @@ auto parse_command_line(int argc, char ** argv) -> command_line_args {
                 args.method = method::stochastic_gradient;
             else if (value == "importance-sampling")
                 args.method = method::importance_sampling;
+            else if (value == "empirical")
+                args.method = method::empirical;
             else
                 throw "bad method name: " + value;
         } else if (option == "--averaging") {
@@ -30,6 +39,39 @@ auto parse_command_line(int argc, char ** argv) -> command_line_args {
                 args.averaging = averaging::no;
             else
                 throw "bad averaging parameter: " + value;
+        } else if (option == "--antithetic") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--antithetic`";
+            auto value = std::string { argv[i] };
+            if (value == "yes")
+                args.antithetic_mode = antithetic::yes;
+            else if (value == "no")
+                args.antithetic_mode = antithetic::no;
+            else
+                throw "bad antithetic parameter: " + value;
+        } else if (option == "--control") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--control`";
+            auto value = std::string { argv[i] };
+            if (value == "yes")
+                args.control = true;
+            else if (value == "no")
+                args.control = false;
+            else
+                throw "bad control parameter: " + value;
+        } else if (option == "--switching") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--switching`";
+            auto value = std::string { argv[i] };
+            if (value == "fixed")
+                args.switching_mode = switching::fixed;
+            else if (value == "adaptive")
+                args.switching_mode = switching::adaptive;
+            else
+                throw "bad switching parameter: " + value;
         } else if (option == "--step") {
             ++i;
             if (i == argc)
@@ -45,23 +87,175 @@ auto parse_command_line(int argc, char ** argv) -> command_line_args {
             try { args.offset = std::stod(value); } catch(...) { args.offset = -1.; }
             if (args.offset < 0)
                 throw "bad offset value: " + value;
+        } else if (option == "--batch") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--batch`";
+            auto value = std::string { argv[i] };
+            try { args.batch = std::stoi(value); } catch(...) { args.batch = -1; }
+            if (args.batch <= 0)
+                throw "bad batch value: " + value;
+        } else if (option == "--replicas") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--replicas`";
+            auto value = std::string { argv[i] };
+            try { args.replicas = std::stoi(value); } catch(...) { args.replicas = -1; }
+            if (args.replicas <= 0)
+                throw "bad replicas value: " + value;
+        } else if (option == "--surrogate") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--surrogate`";
+            auto value = std::string { argv[i] };
+            try { args.surrogate = std::stod(value); } catch(...) { args.surrogate = -1.; }
+            if (args.surrogate <= 0)
+                throw "bad surrogate tolerance: " + value;
+        } else if (option == "--chains") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--chains`";
+            auto value = std::string { argv[i] };
+            try { args.chains = std::stoi(value); } catch(...) { args.chains = -1; }
+            if (args.chains <= 0)
+                throw "bad chains value: " + value;
+        } else if (option == "--pipeline") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--pipeline`";
+            auto value = std::string { argv[i] };
+            try { args.pipeline = std::stoi(value); } catch(...) { args.pipeline = -1; }
+            if (args.pipeline <= 0)
+                throw "bad pipeline value: " + value;
+        } else if (option == "--threads") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--threads`";
+            auto value = std::string { argv[i] };
+            try { args.threads = std::stoi(value); } catch(...) { args.threads = -1; }
+            if (args.threads <= 0)
+                throw "bad threads value: " + value;
+        } else if (option == "--tol") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--tol`";
+            auto value = std::string { argv[i] };
+            try { args.tolerance = std::stod(value); } catch(...) { args.tolerance = -1.; }
+            if (args.tolerance <= 0)
+                throw "bad tolerance value: " + value;
+        } else if (option == "--record") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--record`";
+            args.record = std::string { argv[i] };
+        } else if (option == "--checkpoint") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--checkpoint`";
+            args.checkpoint_args.path = std::string { argv[i] };
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--checkpoint`";
+            auto value = std::string { argv[i] };
+            try { args.checkpoint_args.every = std::stoi(value); } catch(...) { args.checkpoint_args.every = -1; }
+            if (args.checkpoint_args.every < 0)
+                throw "bad checkpoint interval: " + value;
+        } else if (option == "--metrics") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--metrics`";
+            args.metrics = std::string { argv[i] };
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--metrics`";
+            auto value = std::string { argv[i] };
+            try { args.metrics_every = std::stoll(value); } catch(...) { args.metrics_every = -1; }
+            if (args.metrics_every < 0)
+                throw "bad metrics interval: " + value;
+        } else if (option == "--resume") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--resume`";
+            args.checkpoint_args.resume = std::string { argv[i] };
+        } else if (option == "--seed") {
+            ++i;
+            if (i == argc)
+                throw "missing argument for `--seed`";
+            auto value = std::string { argv[i] };
+            try { args.seed = std::stoull(value); } catch(...) { throw "bad seed value: " + value; }
         } else {
-            if (args.alpha < 0) {
-                try { args.alpha = std::stod(option); } catch(...) { args.alpha = -1.; }
-                if (args.alpha <= 0 || args.alpha >= 1)
-                    throw "bad alpha value: " + option;
-            } else if (args.N < 0) {
-                try { args.N = std::stoi(option); } catch(...) { args.N = -1; }
-                if (args.N <= 100)
-                    throw "bad N value: " + option;
-            }
+            if (parameters.size() == 2)
+                throw "unexpected parameter: " + option;
+            parameters.push_back(option);
         }
         ++i;
     }
 
-    if (args.alpha < 0)
+    for (auto k = parameters.size(); k < defaults.size() && k < 2; ++k) {
+        if (defaults[k].empty())
+            break;
+        parameters.push_back(defaults[k]);
+    }
+    if (parameters.size() < 1)
         throw std::string { "missing parameter alpha" };
-    if (args.N < 0)
+    if (parameters.size() < 2)
         throw std::string { "missing parameter N" };
+
+    // Plusieurs niveaux de confiance peuvent être donnés, séparés par des virgules.
+    std::string::size_type start = 0;
+    while (true) {
+        auto end = parameters[0].find(',', start);
+        auto value = parameters[0].substr(start, end - start);
+        double alpha;
+        try { alpha = std::stod(value); } catch(...) { alpha = -1.; }
+        if (alpha <= 0 || alpha >= 1)
+            throw "bad alpha value: " + value;
+        args.alphas.push_back(alpha);
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+    args.alpha = args.alphas.front();
+    try { args.N = std::stoi(parameters[1]); } catch(...) { args.N = -1; }
+    if (args.N <= 100)
+        throw "bad N value: " + parameters[1];
+
+    if (!args.record.empty() && (args.replicas > 1 || args.alphas.size() > 1))
+        throw std::string { "`--record` needs a single replica and a single alpha" };
+    auto checkpointing = !args.checkpoint_args.path.empty() || !args.checkpoint_args.resume.empty();
+    if (checkpointing && (args.replicas > 1 || args.alphas.size() > 1 || !args.record.empty()))
+        throw std::string { "`--checkpoint` and `--resume` need a single replica, a single alpha and no `--record`" };
+    if (args.tolerance > 0 && (!args.record.empty() || checkpointing))
+        throw std::string { "`--tol` is not available with `--record`, `--checkpoint` and `--resume`" };
+    // `--tol` compare des réplicas indépendants, cf `src/stopping.hpp`.
+    if (args.tolerance > 0 && args.replicas == 1)
+        args.replicas = 8;
+    if (args.batch > 1 && args.method != method::stochastic_gradient)
+        throw std::string { "`--batch` needs the stochastic gradient method" };
+    auto reduces_variance = args.antithetic_mode == antithetic::yes || args.control;
+    if (reduces_variance && (args.method != method::stochastic_gradient || args.batch > 1))
+        throw std::string { "`--antithetic` and `--control` need the stochastic gradient method without `--batch`" };
+    if (args.chains > 1 && (args.method != method::importance_sampling || args.replicas > 1
+        || args.tolerance > 0 || !args.record.empty() || checkpointing))
+        throw std::string { "`--chains` needs the importance sampling method without `--replicas`, `--tol`, `--record`, `--checkpoint` and `--resume`" };
+    if (args.method == method::empirical && (args.replicas > 1 || args.tolerance > 0
+        || !args.record.empty() || checkpointing))
+        throw std::string { "`--method empirical` is not available with `--replicas`, `--tol`, `--record`, `--checkpoint` and `--resume`" };
+    if (args.pipeline > 0 && (args.method != method::stochastic_gradient || args.batch > 1
+        || args.replicas > 1 || args.tolerance > 0 || !args.record.empty() || checkpointing
+        || reduces_variance))
+        throw std::string { "`--pipeline` needs the stochastic gradient method without `--batch`, `--replicas`, `--tol`, `--record`, `--checkpoint`, `--resume`, `--antithetic` and `--control`" };
+    if (!args.metrics.empty() && (args.method != method::importance_sampling || args.replicas > 1
+        || args.chains > 1 || args.tolerance > 0 || checkpointing))
+        throw std::string { "`--metrics` needs the importance sampling method without `--replicas`, `--chains`, `--tol`, `--checkpoint` and `--resume`" };
+    if (args.switching_mode == switching::adaptive && (args.method != method::importance_sampling
+        || args.chains > 1 || checkpointing))
+        throw std::string { "`--switching adaptive` needs the importance sampling method without `--chains`, `--checkpoint` and `--resume`" };
+    if (args.N / 100 / args.chains <= 0)
+        throw std::string { "too many chains for N iterations" };
+    if (args.N / args.batch <= 100)
+        throw std::string { "batch too large for N iterations" };
+    if (args.N / args.replicas <= 100)
+        throw std::string { "too many replicas for N iterations" };
     return args;
 }
@@ -1,22 +1,332 @@
 #ifndef COMMAND_LINE_HPP
 #define COMMAND_LINE_HPP
 
-#include "src/averaging.hpp"
+#include "src/estimate.hpp"
+#include "src/parallel.hpp"
+#include "src/stopping.hpp"
+#include "src/record.hpp"
+#include "src/checkpoint.hpp"
+#include "src/switching.hpp"
+#include "src/surrogate.hpp"
+#include "src/metrics.hpp"
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <algorithm> // `std::max`
 
 enum class method {
     stochastic_gradient,
     importance_sampling,
+    empirical, // valeurs de référence, cf `src/estimate.hpp/empirical_kernel`
 };
 
 struct command_line_args {
-    double alpha = -1.;
+    double alpha = -1.; // premier niveau de confiance de `alphas`
+    std::vector<double> alphas;
     int N = -1;
     method method = method::stochastic_gradient;
     averaging averaging = averaging::no;
     double exponent = 1.;
     double offset = 0.;
+    int batch = 1;
+    int replicas = 1;
+    switching switching_mode = switching::fixed;
+    int chains = 1; // suites parallèles de l'importance sampling, cf `IS_kernel::parallel_compute`
+    int pipeline = 0; // producteurs de `approx_kernel::pipelined_compute`, 0 sans pipeline
+    int threads = detail::default_threads();
+    std::uint64_t seed = 0;
+    double tolerance = -1.;
+    std::string record; // fichier de trajectoire, vide si l'on n'enregistre rien
+    checkpoint checkpoint_args; // sauvegardes et reprise, cf `src/checkpoint.hpp`
+    antithetic antithetic_mode = antithetic::no;
+    bool control = false; // utiliser la variable de contrôle fournie à `run_command_line`
+    double surrogate = -1.; // tolérance de la table de `src/surrogate.hpp`, négative sans table
+    std::string metrics; // fichier des mesures de `src/metrics.hpp`, vide sans mesures
+    long long metrics_every = 0; // pas entre deux mesures périodiques, 0 sans mesures périodiques
 };
 
-auto parse_command_line(int, char **) -> command_line_args;
+// Les paramètres positionnels absents de la ligne de commande sont pris, dans l'ordre `alpha`
+// puis `N`, dans `defaults`, où une chaîne vide n'en donne aucun (cf `var_engine.cpp`).
+auto parse_command_line(int, char **, const std::vector<std::string> & defaults = {}) -> command_line_args;
+
+// Exécute le noyau de calcul `kernel` en tenant compte des options de `args` (réplicas
+// parallèles ou non), puis écrit le résultat sur la sortie standard, cf `README.txt`.
+template<class Kernel, class Distribution, class Generator>
+void print_estimate(
+    Kernel kernel,
+    const command_line_args & args,
+    Distribution & d,
+    Generator & g
+) {
+    // Critère d'arrêt (cf `src/stopping.hpp`): sans `--tol`, on fait exactement `N`
+    // itérations. Sinon, les réplicas se comparent à partir d'un millième du nombre maximal de
+    // pas de chacun, puis à chaque doublement.
+    if (args.tolerance > 0) {
+        auto steps = args.N / args.batch / args.replicas;
+        tolerance rule { args.tolerance, args.replicas, std::max(steps / 1000, 100) };
+        auto result = replicate(kernel, args.replicas, args.threads).compute(d, g, rule);
+        std::cout << result.xi << "," << result.C << ","
+                  << result.xi_error << "," << result.C_error << std::endl;
+        if (rule.iterations() < 0)
+            std::cerr << "tolerance not reached: error bounds " << rule.xi_error() << " for xi, "
+                      << rule.C_error() << " for C" << std::endl;
+        return;
+    }
+
+    // Sauvegardes et reprise (incompatibles avec `--replicas` et `--record`).
+    if (!args.checkpoint_args.path.empty() || !args.checkpoint_args.resume.empty()) {
+        detail::no_observer none;
+        auto result = kernel.compute(d, g, none, args.checkpoint_args);
+        std::cout << result.first << "," << result.second << std::endl;
+        return;
+    }
+
+    // Enregistrement de la trajectoire (incompatible avec `--replicas`, cf `parse_command_line`):
+    // on garde au plus 100000 termes, espacés logarithmiquement.
+    if (!args.record.empty()) {
+        trajectory_recorder recorder { args.record, 100000, 1, 1.01 };
+        auto result = kernel.compute(d, g, recorder);
+        std::cout << result.first << "," << result.second << std::endl;
+        return;
+    }
+
+    if (args.replicas == 1) {
+        auto result = kernel.compute(d, g);
+        std::cout << result.first << "," << result.second << std::endl;
+    } else {
+        auto result = replicate(kernel, args.replicas, args.threads).compute(d, g);
+        std::cout << result.xi << "," << result.C << ","
+                  << result.xi_error << "," << result.C_error << std::endl;
+    }
+}
+
+// Exécute tous les calculs demandés par `args` pour la fonction de perte `phi` et la loi `d`,
+// avec la suite de pas `step` choisie par `steps::dispatch`, et écrit les résultats sur la
+// sortie standard. Après les résultats de chaque niveau de confiance `alpha`, on appelle
+// `after(alpha)`, par exemple pour écrire des valeurs de référence. `control` est la variable
+// de contrôle utilisée avec `--control` (`detail::no_control` si le modèle n'en a pas).
+template<class Phi, class Distribution, class Generator, class After, class Control>
+class command_line_runner {
+    private:
+        const command_line_args & args;
+        const Phi & phi;
+        Distribution & d;
+        Generator & g;
+        const After & after;
+        const Control & control;
+
+        template<class Gamma, class H>
+        void print_controlled(
+            double alpha,
+            const Gamma & step,
+            const control_variate<H> & control
+        ) const {
+            print_estimate(
+                stochastic_gradient(
+                    alpha,
+                    args.N,
+                    phi,
+                    step,
+                    control,
+                    args.averaging,
+                    args.antithetic_mode
+                ),
+                args,
+                d,
+                g
+            );
+        }
+
+        template<class Gamma>
+        void print_controlled(double, const Gamma &, const detail::no_control &) const {
+            throw std::string { "no control variate available for this model" };
+        }
+
+        // Importance sampling sur `args.chains` suites parallèles (option `--chains`).
+        template<class Kernel>
+        void print_parallel(Kernel kernel) const {
+            auto result = kernel.parallel_compute(d, g, args.chains, args.threads);
+            std::cout << result.first << "," << result.second << std::endl;
+        }
+
+        // Importance sampling avec `--metrics`: les mesures sont écrites périodiquement et à la
+        // fin du calcul, cf `src/metrics.hpp`. Le fichier est vidé au premier niveau de
+        // confiance, puis complété pour les suivants.
+        template<class Kernel>
+        void print_measured(double alpha, Kernel kernel) const {
+            std::ofstream file;
+            if (args.metrics != "-") {
+                auto mode = alpha == args.alphas.front() ? std::ios::trunc : std::ios::app;
+                file.open(args.metrics, std::ios::out | mode);
+                if (!file)
+                    throw "cannot open `" + args.metrics + "`";
+            }
+            std::ostream & out = args.metrics == "-" ? std::cerr : file;
+            IS_metrics metrics { &out, args.metrics_every };
+            kernel.measure(metrics);
+            print_estimate(kernel, args, d, g);
+            metrics.write_json(out);
+        }
+
+    public:
+        command_line_runner(
+            const command_line_args & args,
+            const Phi & phi,
+            Distribution & d,
+            Generator & g,
+            const After & after,
+            const Control & control
+        ) : args(args), phi(phi), d(d), g(g), after(after), control(control)
+        {
+        }
+
+        template<class Gamma>
+        void operator ()(const Gamma & step) const {
+            // Plusieurs niveaux de confiance avec l'algorithme naïf: on les calcule en une seule
+            // passe.
+            if (args.alphas.size() > 1 && args.method == method::stochastic_gradient
+                && args.replicas == 1 && args.batch == 1 && args.record.empty()
+                && args.checkpoint_args.path.empty() && args.checkpoint_args.resume.empty()
+                && args.antithetic_mode == antithetic::no && !args.control && args.pipeline == 0) {
+                auto kernel = stochastic_gradient_levels(args.alphas, args.N, phi, step, args.averaging);
+                auto results = kernel.compute(d, g);
+                for (std::size_t k = 0; k < results.size(); ++k) {
+                    std::cout << results[k].first << "," << results[k].second << std::endl;
+                    after(args.alphas[k]);
+                }
+                return;
+            }
+
+            for (auto alpha : args.alphas) {
+                if (args.method == method::empirical) {
+                    auto result = empirical_estimate(alpha, args.N, phi, args.threads)
+                        .compute(d, g);
+                    std::cout << result.first << "," << result.second << std::endl;
+                } else if (args.pipeline > 0) {
+                    auto result = stochastic_gradient(alpha, args.N, phi, step, args.averaging)
+                        .pipelined_compute(d, g, args.pipeline);
+                    std::cout << result.first << "," << result.second << std::endl;
+                } else if (args.method == method::stochastic_gradient && args.control)
+                    print_controlled(alpha, step, control);
+                else if (args.method == method::stochastic_gradient)
+                    print_estimate(
+                        stochastic_gradient(
+                            alpha,
+                            args.N,
+                            phi,
+                            step,
+                            args.averaging,
+                            args.batch,
+                            args.antithetic_mode
+                        ),
+                        args,
+                        d,
+                        g
+                    );
+                else if (!args.metrics.empty())
+                    print_measured(
+                        alpha,
+                        importance_sampling(
+                            alpha,
+                            1.,
+                            args.N,
+                            phi,
+                            step,
+                            args.averaging,
+                            args.switching_mode
+                        )
+                    );
+                else if (args.chains > 1)
+                    print_parallel(
+                        importance_sampling(
+                            alpha,
+                            1.,
+                            args.N,
+                            phi,
+                            step,
+                            args.averaging,
+                            args.switching_mode
+                        )
+                    );
+                else
+                    print_estimate(
+                        importance_sampling(
+                            alpha,
+                            1.,
+                            args.N,
+                            phi,
+                            step,
+                            args.averaging,
+                            args.switching_mode
+                        ),
+                        args,
+                        d,
+                        g
+                    );
+                after(alpha);
+            }
+        }
+};
+
+// Fonction utilitaire pour inférer les paramètres template de `command_line_runner`; le choix
+// de la suite de pas n'est fait qu'une fois, cf `src/steps.hpp/steps::dispatch`.
+template<class Phi, class Distribution, class Generator, class After, class Control>
+void dispatch_command_line(
+    const command_line_args & args,
+    const Phi & phi,
+    Distribution & d,
+    Generator & g,
+    const After & after,
+    const Control & control
+) {
+    steps::dispatch(
+        args.exponent,
+        args.offset,
+        command_line_runner<Phi, Distribution, Generator, After, Control> {
+            args,
+            phi,
+            d,
+            g,
+            after,
+            control
+        }
+    );
+}
+
+// Exécute les calculs demandés par `args`, cf `command_line_runner`. Avec `--surrogate`, on
+// remplace d'abord `phi` par une table d'interpolation (cf `src/surrogate.hpp`), dont on écrit
+// les caractéristiques sur la sortie d'erreur.
+template<class Phi, class Distribution, class Generator, class After, class Control>
+void run_command_line(
+    const command_line_args & args,
+    const Phi & phi,
+    Distribution & d,
+    Generator & g,
+    const After & after,
+    const Control & control
+) {
+    if (args.surrogate > 0) {
+        auto table = tabulate(phi, d, args.surrogate);
+        std::cerr << "surrogate: " << table.cells() << " cells, " << table.exact_cells()
+                  << " evaluated exactly, max error " << table.max_error() << std::endl;
+        dispatch_command_line(args, table, d, g, after, control);
+    } else {
+        dispatch_command_line(args, phi, d, g, after, control);
+    }
+}
+
+// Idem, pour un modèle sans variable de contrôle.
+template<class Phi, class Distribution, class Generator, class After>
+void run_command_line(
+    const command_line_args & args,
+    const Phi & phi,
+    Distribution & d,
+    Generator & g,
+    const After & after
+) {
+    run_command_line(args, phi, d, g, after, detail::no_control { });
+}
 
 #endif
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "src/estimate.hpp"
+#include "src/random.hpp"
 #include "command_line.hpp"
 #include <random>
 #include <iostream>
@@ -21,21 +22,22 @@ auto main(int argc, char ** argv) -> int {
         return 1;
     }
 
-    std::random_device rd;
-    auto g = std::mt19937 { rd() };
+    auto g = philox4x32 { args.seed };
     auto lambda = 2.;
     auto d = std::exponential_distribution<> { lambda };
 
     auto phi = identity;
-    
-    std::pair<double, double> result;
-    auto step = steps::inverse_pow(args.exponent, args.offset);
-    if (args.method == method::stochastic_gradient) {
-        result = stochastic_gradient(args.alpha, args.N, phi, step, args.averaging).compute(d, g);
-    } else {
-        result = importance_sampling(args.alpha, 1., args.N, phi, step, args.averaging).compute(d, g);
+
+    // Variable de contrôle pour `--control`: $X$ lui-même, d'espérance $\frac{1}{\lambda}$.
+    auto mean = 1 / lambda;
+
+    try {
+        run_command_line(args, phi, d, g, [lambda](double alpha) {
+            std::cout << var(alpha, lambda) << "," << cvar(alpha, lambda) << std::endl;
+        }, control(identity, mean));
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
     }
-    std::cout << result.first << "," << result.second << std::endl;
-    std::cout << var(args.alpha, lambda) << "," << cvar(args.alpha, lambda) << std::endl;
     return 0;
 }
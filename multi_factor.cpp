@@ -0,0 +1,167 @@
+#include "src/estimate.hpp"
+#include "src/multivariate.hpp"
+#include "src/random.hpp"
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <cstdint>
+
+// Portefeuille de puts vendus sur `d` sous-jacents corrélés, cf `README.txt`.
+
+struct multi_factor_args {
+    double alpha = -1.;
+    int N = -1;
+    int factors = 10;
+    double correlation = 0.5;
+    std::string method = "importance-sampling";
+    averaging avg = averaging::no;
+    double exponent = 0.5; // les pertes se comptent en centaines: avec $\frac{1}{n}$, $\xi$ n'avance
+    double offset = 1.;    // que d'environ $\log N$, cf `README.txt`
+    std::uint64_t seed = 0;
+};
+
+auto parse_multi_factor_args(int argc, char ** argv) -> multi_factor_args {
+    multi_factor_args args;
+    std::random_device rd;
+    args.seed = static_cast<std::uint64_t>(rd()) << 32 | rd();
+
+    for (int i = 1; i < argc; ++i) {
+        auto option = std::string { argv[i] };
+        auto next = [&]() -> std::string {
+            if (++i == argc)
+                throw "missing argument for `" + option + "`";
+            return std::string { argv[i] };
+        };
+        if (option == "--factors") {
+            auto value = next();
+            try { args.factors = std::stoi(value); } catch(...) { args.factors = -1; }
+            if (args.factors <= 0)
+                throw "bad number of factors: " + value;
+        } else if (option == "--correlation") {
+            auto value = next();
+            try { args.correlation = std::stod(value); } catch(...) { args.correlation = -2.; }
+            if (args.correlation <= -1 || args.correlation >= 1)
+                throw "bad correlation: " + value;
+        } else if (option == "--method") {
+            args.method = next();
+            if (args.method != "stochastic-gradient" && args.method != "importance-sampling"
+                && args.method != "empirical")
+                throw "bad method name: " + args.method;
+        } else if (option == "--averaging") {
+            auto value = next();
+            if (value == "yes")
+                args.avg = averaging::yes;
+            else if (value == "no")
+                args.avg = averaging::no;
+            else
+                throw "bad averaging parameter: " + value;
+        } else if (option == "--step") {
+            auto value = next();
+            try { args.exponent = std::stod(value); } catch(...) { args.exponent = -1.; }
+            if (args.exponent <= 0 || args.exponent > 1)
+                throw "bad exponent value: " + value;
+            value = next();
+            try { args.offset = std::stod(value); } catch(...) { args.offset = -1.; }
+            if (args.offset < 0)
+                throw "bad offset value: " + value;
+        } else if (option == "--seed") {
+            auto value = next();
+            try { args.seed = std::stoull(value); } catch(...) {
+                throw "bad seed value: " + value;
+            }
+        } else if (args.alpha < 0) {
+            try { args.alpha = std::stod(option); } catch(...) { args.alpha = -1.; }
+            if (args.alpha <= 0 || args.alpha >= 1)
+                throw "bad alpha value: " + option;
+        } else if (args.N < 0) {
+            try { args.N = std::stoi(option); } catch(...) { args.N = -1; }
+            if (args.N <= 100)
+                throw "bad N value: " + option;
+        } else {
+            throw "unknown option: " + option;
+        }
+    }
+    if (args.alpha < 0)
+        throw std::string { "missing parameter alpha" };
+    if (args.N < 0)
+        throw std::string { "missing parameter N" };
+    if (args.factors * (1 - args.correlation) <= 0 || 1 + (args.factors - 1) * args.correlation <= 0)
+        throw std::string { "covariance matrix is not positive definite" };
+    return args;
+}
+
+// Perte d'un put vendu sur chaque sous-jacent, avec les paramètres de `short_put.cpp`; le
+// facteur $x_j$ est le tirage normal centré réduit qui dirige le $j$-ième sous-jacent.
+class short_puts {
+    private:
+        losses::european_put put;
+
+    public:
+        short_puts() : put { losses::black_scholes { 100, 0.2, 0.05, 1 }, 110, -1, 10.7 }
+        {
+        }
+
+        auto operator ()(const factors & x) const -> double {
+            double result = 0;
+            for (std::size_t j = 0; j < x.size(); ++j)
+                result += put(x[j]);
+            return result;
+        }
+};
+
+// Exécute le calcul avec la suite de pas choisie par `steps::dispatch`.
+class multi_factor_runner {
+    private:
+        const multi_factor_args & args;
+        gaussian_factors & d;
+        philox4x32 & g;
+        const short_puts & phi;
+        std::pair<double, double> & result;
+
+    public:
+        multi_factor_runner(
+            const multi_factor_args & args,
+            gaussian_factors & d,
+            philox4x32 & g,
+            const short_puts & phi,
+            std::pair<double, double> & result
+        ) : args(args), d(d), g(g), phi(phi), result(result)
+        {
+        }
+
+        template<class Gamma>
+        void operator ()(const Gamma & gamma) const {
+            if (args.method == "stochastic-gradient")
+                result = stochastic_gradient(args.alpha, args.N, phi, gamma, args.avg).compute(d, g);
+            else
+                result = importance_sampling(args.alpha, 1., args.N, phi, gamma, args.avg)
+                    .compute(d, g);
+        }
+};
+
+auto main(int argc, char ** argv) -> int {
+    try {
+        auto args = parse_multi_factor_args(argc, argv);
+        auto d = gaussian_factors {
+            factors(args.factors),
+            equicorrelated(args.factors, 1., args.correlation)
+        };
+        auto g = philox4x32 { args.seed };
+        short_puts phi;
+
+        std::pair<double, double> result;
+        if (args.method == "empirical")
+            result = empirical_estimate(args.alpha, args.N, phi).compute(d, g);
+        else
+            steps::dispatch(args.exponent, args.offset, multi_factor_runner { args, d, g, phi, result });
+        std::cout << result.first << "," << result.second << std::endl;
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
+    } catch (const char * s) {
+        std::cerr << s << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,7 +1,9 @@
 #include "src/estimate.hpp"
+#include "src/random.hpp"
 #include "command_line.hpp"
 #include <random>
 #include <iostream>
+#include <cmath> // `std::exp`, `std::log`, `std::erfc`, `std::sqrt`
 
 auto main(int argc, char ** argv) -> int {
     command_line_args args;
@@ -12,25 +14,29 @@ auto main(int argc, char ** argv) -> int {
         return 1;
     }
 
-    std::random_device rd;
-    auto g = std::mt19937 { rd() };
+    auto g = philox4x32 { args.seed };
     auto d = std::normal_distribution<> { 0., 1. };
 
-    auto phi = [](double x) {
-        auto S = 100 * std::exp((0.05 - 0.2 * 0.2 / 2) + 0.2 * x);
-        auto result = -std::exp(0.05) * 10.7;
-        if (110 < S)
-            return result;
-        return 110 - S + result;
+    // Position courte sur un put de strike 110, vendu 10.7, cf `src/losses.hpp`.
+    auto model = losses::black_scholes { 100, 0.2, 0.05, 1 };
+    auto phi = losses::european_put { model, 110, -1, 10.7 };
+
+    // Variable de contrôle pour `--control`: le paiement du put, dont l'espérance est le prix de
+    // Black-Scholes capitalisé, $E[(K - S)^+] = K \Phi(-d_2) - S_0 e^r \Phi(-d_1)$.
+    auto payoff = [&model](double x) {
+        auto S = model.underlying(x);
+        return 110 < S ? 0. : 110 - S;
     };
-    
-    std::pair<double, double> result;
-    auto step = steps::inverse_pow(args.exponent, args.offset);
-    if (args.method == method::stochastic_gradient) {
-        result = stochastic_gradient(args.alpha, args.N, phi, step, args.averaging).compute(d, g);
-    } else {
-        result = importance_sampling(args.alpha, 1., args.N, phi, step, args.averaging).compute(d, g);
+    auto N = [](double x) { return 0.5 * std::erfc(-x / std::sqrt(2.)); };
+    auto d1 = (std::log(100. / 110.) + 0.05 + 0.2 * 0.2 / 2) / 0.2;
+    auto d2 = d1 - 0.2;
+    auto put = 110 * N(-d2) - 100 * std::exp(0.05) * N(-d1);
+
+    try {
+        run_command_line(args, phi, d, g, [](double) { }, control(payoff, put));
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
     }
-    std::cout << result.first << "," << result.second << std::endl;
     return 0;
 }
@@ -0,0 +1,21 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <string>
+
+// Sauvegardes périodiques de l'état complet d'un calcul, à passer aux méthodes `compute` de
+// `src/estimate.hpp`: termes courants de la suite ($\xi_n$, $C_n$, $\theta_n$, $\mu_n$),
+// accumulateur de la moyennisation, générateur, distribution et réalisations déjà tirées mais
+// pas encore consommées. Un calcul repris depuis une sauvegarde donne donc exactement le même
+// résultat, au bit près, que le calcul ininterrompu. Reprendre un calcul terminé avec un
+// nombre d'itérations plus grand permet de repartir d'un état déjà convergé.
+//
+// L'état des observateurs (critère d'arrêt, enregistrement de trajectoire) n'est pas
+// sauvegardé: ils repartent de zéro lors d'une reprise.
+struct checkpoint {
+    std::string path; // fichier de sauvegarde, vide si l'on ne sauvegarde rien
+    int every = 0; // nombre d'itérations entre deux sauvegardes (0: seulement à la fin)
+    std::string resume; // sauvegarde dont on repart, vide pour un calcul neuf
+};
+
+#endif
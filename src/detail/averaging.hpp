@@ -1,8 +1,10 @@
 #ifndef DETAIL_AVERAGING_HPP
 #define DETAIL_AVERAGING_HPP
 
-#include "tuple.hpp"
+#include "state.hpp"
 #include <utility> // `std::move`
+#include <istream>
+#include <ostream>
 
 namespace detail {
 
@@ -12,25 +14,44 @@ class averaging {
 private:
     Sequence state;
     typename Sequence::result_type avg_state;
-    int n = 0;
+    long long n = 0;
 
 public:
     using result_type = typename Sequence::result_type;
 
-    averaging(Sequence state) : state { std::move(state) }
+    averaging(Sequence state) : state { std::move(state) }, avg_state {}
     {
     }
 
-    auto next() -> result_type {
+    // La moyenne est mise à jour sur place; la référence renvoyée est valable jusqu'au
+    // prochain appel.
+    auto next() -> const result_type & {
         if (n == 0) {
             avg_state = state.next();
             ++n;
             return avg_state;
         }
-        avg_state = avg_state - (avg_state - state.next()) / n;
+        auto x = state.next();
+        x -= avg_state;
+        x /= n;
+        avg_state += x;
         ++n;
         return avg_state;
     }
+
+    // Sauvegarde et restauration de l'état complet, cf `src/checkpoint.hpp`.
+    void save(std::ostream & os) const {
+        os << n << ' ';
+        write(os, avg_state);
+        os << '\n';
+        state.save(os);
+    }
+
+    void load(std::istream & is) {
+        is >> n;
+        read(is, avg_state);
+        state.load(is);
+    }
 };
 
 }
@@ -0,0 +1,152 @@
+#ifndef DETAIL_CHECKPOINT_HPP
+#define DETAIL_CHECKPOINT_HPP
+
+#include "../checkpoint.hpp"
+#include "state.hpp"
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <limits> // `std::numeric_limits`
+#include <cstdio> // `std::rename`
+
+namespace detail {
+
+// Format d'un fichier de sauvegarde (texte):
+//     monte_carlo-checkpoint <version>
+//     <description du noyau de calcul>
+//     <phase> <nombre de termes déjà calculés>
+//     <dernier terme calculé>
+//     <générateur>
+//     <distribution>
+//     <état de la suite, cf les méthodes `save` des suites>
+// Les flottants sont écrits avec assez de chiffres pour être relus à l'identique.
+constexpr int checkpoint_version = 1;
+
+// Description d'une suite de pas $n \longmapsto \gamma_n$ pour l'en-tête des sauvegardes: ses
+// valeurs en quelques points, qui distinguent l'exposant et le décalage des suites de
+// `src/steps.hpp`, quel que soit le type de `Gamma`.
+template<class Gamma>
+auto describe_steps(const Gamma & gamma) -> std::string {
+    std::ostringstream os;
+    os.precision(std::numeric_limits<double>::max_digits10);
+    os << "steps=" << gamma(1) << "," << gamma(10) << "," << gamma(1000) << ","
+       << gamma(1000000);
+    return os.str();
+}
+
+// Effectue les itérations d'une ou plusieurs suites en écrivant des sauvegardes, et en
+// reprenant éventuellement depuis une sauvegarde. `kind` décrit le noyau de calcul: une
+// sauvegarde ne peut être reprise que par un noyau de même description. Pour un noyau à
+// plusieurs phases (`IS_kernel`), `phase` distingue les suites successives.
+template<class Distribution, class Generator>
+class checkpointed {
+    private:
+        const checkpoint & cp;
+        std::string kind;
+        Distribution & d;
+        Generator & g;
+        int resumed = -1;
+
+        // Ouvre `path` et lit l'en-tête; renvoie la phase et le nombre de termes calculés.
+        void open(std::ifstream & in, int & phase, int & n) const {
+            in.open(cp.resume);
+            if (!in)
+                throw "cannot open checkpoint `" + cp.resume + "`";
+            std::string magic, description;
+            int version;
+            in >> magic >> version;
+            if (!in || magic != "monte_carlo-checkpoint" || version != checkpoint_version)
+                throw "`" + cp.resume + "` is not a checkpoint file";
+            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::getline(in, description);
+            if (description != kind)
+                throw "checkpoint `" + cp.resume + "` was written by another computation: "
+                    + description;
+            in >> phase >> n;
+            if (!in)
+                throw "corrupted checkpoint `" + cp.resume + "`";
+        }
+
+        template<class Sequence>
+        void save(
+            int phase,
+            int n,
+            const Sequence & sequence,
+            const typename Sequence::result_type & state
+        ) const {
+            auto tmp = cp.path + ".tmp";
+            {
+                std::ofstream out { tmp };
+                out.precision(std::numeric_limits<double>::max_digits10);
+                out << "monte_carlo-checkpoint " << checkpoint_version << '\n' << kind << '\n'
+                    << phase << ' ' << n << '\n';
+                write(out, state);
+                out << '\n' << g << '\n' << d << '\n';
+                sequence.save(out);
+                if (!out)
+                    throw "cannot write checkpoint `" + tmp + "`";
+            }
+            // On n'écrase l'ancienne sauvegarde qu'une fois la nouvelle complète.
+            if (std::rename(tmp.c_str(), cp.path.c_str()) != 0)
+                throw "cannot write checkpoint `" + cp.path + "`";
+        }
+
+    public:
+        checkpointed(const checkpoint & cp, std::string kind, Distribution & d, Generator & g) :
+            cp(cp), kind { std::move(kind) }, d(d), g(g)
+        {
+            if (!cp.resume.empty()) {
+                std::ifstream in;
+                int n;
+                open(in, resumed, n);
+            }
+        }
+
+        // Phase de la sauvegarde dont on repart, -1 si l'on ne reprend rien.
+        auto resumed_phase() const -> int {
+            return resumed;
+        }
+
+        // Cf `iterate` dans `src/detail/iterate.hpp`. Si la sauvegarde à reprendre est de
+        // phase `phase`, on restaure d'abord l'état de `sequence`, de `d` et de `g`, et l'on
+        // continue à partir du terme suivant. Une sauvegarde est écrite toutes les `cp.every`
+        // itérations ainsi qu'à la fin.
+        template<class Sequence, class Observer>
+        auto iterate(
+            Sequence & sequence,
+            int phase,
+            int iterations,
+            Observer & observer
+        ) -> typename Sequence::result_type
+        {
+            typename Sequence::result_type state {};
+            int n = 0;
+            if (phase == resumed) {
+                std::ifstream in;
+                int ignored;
+                open(in, ignored, n);
+                read(in, state);
+                in >> g >> d;
+                sequence.load(in);
+                if (!in)
+                    throw "corrupted checkpoint `" + cp.resume + "`";
+            }
+
+            while (n < iterations) {
+                state = sequence.next();
+                auto go_on = observer(n, state);
+                ++n;
+                if (!go_on)
+                    break;
+                if (cp.every > 0 && n % cp.every == 0 && n < iterations && !cp.path.empty())
+                    save(phase, n, sequence, state);
+            }
+            if (!cp.path.empty())
+                save(phase, n, sequence, state);
+            return state;
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef DETAIL_EMPIRICAL_HPP
+#define DETAIL_EMPIRICAL_HPP
+
+#include "losses.hpp"
+#include "thread_pool.hpp"
+#include "streams.hpp"
+#include <vector>
+#include <mutex>
+#include <limits>
+#include <cstddef> // `std::size_t`
+#include <cmath> // `std::ceil`, `std::llround`, `std::abs`
+#include <algorithm> // `std::min`, `std::max`, `std::nth_element`
+#include <utility> // `std::pair`
+
+namespace detail {
+
+// Taille des tranches de pertes traitées par une même tâche.
+constexpr std::size_t empirical_chunk = 1 << 20;
+
+// Nombre de cases des histogrammes de `empirical_estimate`.
+constexpr int empirical_bins = 1 << 16;
+
+// Suite de `samples` pertes $\phi(X_i)$ découpée en tranches de `empirical_chunk` pertes, que
+// l'on peut parcourir plusieurs fois en parallèle. Chaque tranche a son propre générateur, tiré
+// de `g` à la construction: si les pertes ne tiennent pas dans `memory` flottants, chaque
+// parcours les tire à nouveau à partir d'une copie de ce générateur, et retrouve donc
+// exactement les mêmes valeurs. Sinon, elles sont tirées une fois pour toutes.
+template<class Phi, class Distribution, class Generator>
+class loss_chunks {
+    private:
+        const Phi & phi;
+        const Distribution & d;
+        std::vector<Generator> generators;
+        long long samples;
+        int threads;
+        std::vector<double> stored;
+
+        void draw(int c, double * out) const {
+            auto local_d = d;
+            local_d.reset();
+            auto local_g = generators[c];
+            loss_sampler<Phi, Distribution, Generator> sample { phi, local_d, local_g };
+            sample.fill(out, size(c));
+        }
+
+    public:
+        loss_chunks(
+            const Phi & phi,
+            const Distribution & d,
+            Generator & g,
+            long long samples,
+            int threads,
+            std::size_t memory
+        ) : phi(phi), d(d), samples { samples }, threads { threads }
+        {
+            auto chunk = static_cast<long long>(empirical_chunk);
+            auto count = (samples + chunk - 1) / chunk;
+            for (long long c = 0; c < count; ++c)
+                generators.push_back(split(g));
+
+            if (static_cast<unsigned long long>(samples) <= memory) {
+                stored.resize(samples);
+                parallel_for(chunks(), threads, [&](int c) {
+                    draw(c, stored.data() + c * empirical_chunk);
+                });
+            }
+        }
+
+        auto size() const -> long long {
+            return samples;
+        }
+
+        auto chunks() const -> int {
+            return static_cast<int>(generators.size());
+        }
+
+        // Nombre de pertes de la tranche `c`.
+        auto size(int c) const -> std::size_t {
+            auto start = c * static_cast<long long>(empirical_chunk);
+            return static_cast<std::size_t>(std::min<long long>(empirical_chunk, samples - start));
+        }
+
+        // Appelle `f(c, losses, n)` pour chaque tranche `c`, en parallèle.
+        template<class F>
+        void pass(const F & f) const {
+            parallel_for(chunks(), threads, [&](int c) {
+                if (!stored.empty()) {
+                    f(c, stored.data() + c * empirical_chunk, size(c));
+                    return;
+                }
+                std::vector<double> losses(size(c));
+                draw(c, losses.data());
+                f(c, losses.data(), losses.size());
+            });
+        }
+};
+
+// Indice (à partir de 0) de la V@R de niveau `alpha` parmi `n` pertes triées: la
+// $\lceil \alpha n \rceil$-ième. On ne prend pas l'entier supérieur d'un produit qui ne dépasse
+// un entier que par une erreur d'arrondi (comme `0.95 * 100`).
+inline auto empirical_rank(double alpha, long long n) -> long long {
+    auto target = alpha * n;
+    auto nearest = std::llround(target);
+    auto rank = std::abs(target - nearest) <= 1e-9 * n
+        ? nearest
+        : static_cast<long long>(std::ceil(target));
+    return std::min(std::max(rank, 1LL), n) - 1;
+}
+
+// V@R et CV@R de niveau `alpha` de la loi empirique des pertes de `chunks`, sans les trier.
+// On garde un intervalle `[lo, hi]` qui contient la V@R, ainsi que le nombre de pertes
+// inférieures à `lo`:
+// * une première passe donne le minimum et le maximum des pertes;
+// * tant que l'intervalle contient plus de `empirical_chunk` pertes, une passe calcule
+//   l'histogramme des pertes de l'intervalle sur `empirical_bins` cases, avec le minimum et le
+//   maximum de chaque case; l'intervalle devient la case qui contient la V@R (comme l'indice
+//   d'une case est une fonction croissante de la perte, les pertes de la case sont exactement
+//   celles comprises entre son minimum et son maximum);
+// * une dernière passe recopie les pertes de l'intervalle, dont on extrait la V@R avec
+//   `std::nth_element`, et somme les excès des pertes au-delà de `hi` pour la CV@R.
+// Chaque tâche travaille sur ses propres histogrammes, fusionnés ensuite: les comptes étant
+// entiers et les sommes flottantes étant additionnées dans l'ordre des tranches, le résultat ne
+// dépend pas du nombre de threads.
+template<class Chunks>
+auto empirical_var_cvar(const Chunks & chunks, double alpha) -> std::pair<double, double> {
+    auto n = chunks.size();
+    auto k = empirical_rank(alpha, n);
+    auto count = chunks.chunks();
+
+    std::vector<double> mins(count), maxs(count);
+    chunks.pass([&](int c, const double * x, std::size_t m) {
+        auto lo = x[0], hi = x[0];
+        for (std::size_t i = 1; i < m; ++i) {
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+        mins[c] = lo;
+        maxs[c] = hi;
+    });
+    auto lo = *std::min_element(mins.begin(), mins.end());
+    auto hi = *std::max_element(maxs.begin(), maxs.end());
+
+    long long below = 0, inside = n;
+    while (lo < hi && inside > static_cast<long long>(empirical_chunk)) {
+        auto scale = empirical_bins / (hi - lo);
+        if (!(scale < std::numeric_limits<double>::infinity()))
+            break;
+
+        std::vector<long long> counts(empirical_bins);
+        std::vector<double> bin_lo(empirical_bins, std::numeric_limits<double>::infinity());
+        std::vector<double> bin_hi(empirical_bins, -std::numeric_limits<double>::infinity());
+        std::mutex merge;
+        chunks.pass([&](int, const double * x, std::size_t m) {
+            std::vector<long long> local_counts(empirical_bins);
+            std::vector<double> local_lo(empirical_bins, std::numeric_limits<double>::infinity());
+            std::vector<double> local_hi(empirical_bins, -std::numeric_limits<double>::infinity());
+            for (std::size_t i = 0; i < m; ++i) {
+                if (!(x[i] >= lo && x[i] <= hi))
+                    continue;
+                auto b = std::min(static_cast<int>((x[i] - lo) * scale), empirical_bins - 1);
+                ++local_counts[b];
+                local_lo[b] = std::min(local_lo[b], x[i]);
+                local_hi[b] = std::max(local_hi[b], x[i]);
+            }
+
+            std::lock_guard<std::mutex> lock { merge };
+            for (int b = 0; b < empirical_bins; ++b) {
+                counts[b] += local_counts[b];
+                bin_lo[b] = std::min(bin_lo[b], local_lo[b]);
+                bin_hi[b] = std::max(bin_hi[b], local_hi[b]);
+            }
+        });
+
+        auto b = 0;
+        for (; b < empirical_bins - 1 && below + counts[b] <= k; ++b)
+            below += counts[b];
+        inside = counts[b];
+        lo = bin_lo[b];
+        hi = bin_hi[b];
+    }
+
+    // Dernière passe: pertes de `[lo, hi]`, et somme des $(L - hi)^+$ par tranche.
+    std::vector<std::vector<double>> parts(count);
+    std::vector<double> excess(count);
+    std::vector<long long> above(count);
+    chunks.pass([&](int c, const double * x, std::size_t m) {
+        double sum = 0;
+        long long more = 0;
+        for (std::size_t i = 0; i < m; ++i) {
+            if (x[i] > hi) {
+                sum += x[i] - hi;
+                ++more;
+            } else if (x[i] >= lo && lo < hi) {
+                parts[c].push_back(x[i]);
+            }
+        }
+        excess[c] = sum;
+        above[c] = more;
+    });
+
+    std::vector<double> candidates;
+    double tail = 0;
+    long long more = 0;
+    for (int c = 0; c < count; ++c) {
+        candidates.insert(candidates.end(), parts[c].begin(), parts[c].end());
+        tail += excess[c];
+        more += above[c];
+    }
+
+    auto xi = lo;
+    if (lo < hi) {
+        auto nth = candidates.begin() + (k - below);
+        std::nth_element(candidates.begin(), nth, candidates.end());
+        xi = *nth;
+        for (auto x : candidates)
+            tail += std::max(x - xi, 0.);
+    }
+    tail += more * (hi - xi);
+    return std::make_pair(xi, xi + tail / ((1 - alpha) * n));
+}
+
+}
+
+#endif
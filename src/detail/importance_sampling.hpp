@@ -2,24 +2,38 @@
 #define DETAIL_IMPORTANCE_SAMPLING_HPP
 
 #include "importance_sampling_parameters.hpp"
-#include <tuple>
+#include "sampler.hpp"
+#include "state.hpp"
+#include "../metrics.hpp"
+#include <vector>
+#include <cmath> // `std::abs`, `std::isfinite`
+#include <algorithm> // `std::max`
+#include <utility> // `std::declval`
+#include <istream>
+#include <ostream>
 
 namespace detail {
 
 // Fonction $L3$ de l'article, définie dans la section 3.1.
 // En plus de $\xi$, $\theta$ et $x$, on prend aussi en argument les paramètres $\rho$,
 // $b$ etc de la distribution choisie via un objet de type `IS_params<Distribution>`.
+// Pour des facteurs multidimensionnels, $\theta$, $x$ et le résultat sont des `factors`.
 template<class InputType, class Phi, class Distribution>
 auto L3(
     double xi,
-    InputType theta,
-    InputType x,
+    const InputType & theta,
+    const InputType & x,
     const Phi & phi,
-    IS_params<Distribution> p
-) -> double {
+    const IS_params<Distribution> & p
+) -> InputType {
     if (phi(x - theta) < xi)
-        return 0;
-    return std::exp(-2 * p.rho() * std::pow(std::abs(theta), p.b())) * p.W(x, theta);
+        return p.zero();
+    // Loin de 0, le facteur s'annule alors que `W` peut devenir infini: on évite de calculer
+    // $0 \times \infty$.
+    auto factor = std::exp(-2 * p.rho() * std::pow(p.norm(theta), p.b()));
+    if (factor == 0)
+        return p.zero();
+    return factor * p.W(x, theta);
 }
 
 // Fonction $L4$ de l'article, définie dans la section 3.1, avec un contrôle
@@ -32,34 +46,184 @@ auto L4(
     const InputType & x,
     double a,
     const Phi & phi,
-    IS_params<Distribution> p
-) -> double {
+    const IS_params<Distribution> & p
+) -> InputType {
     auto diff =  phi(x - mu) - xi;
-    auto norm = std::abs(mu);
+    auto norm = p.norm(mu);
     return std::exp(-2 * a * (norm * norm + 1)) * L3(xi, mu, x, phi, p) * diff * diff;
 }
 
+// Terme $(\xi_n, \theta_n, \mu_n)$ de la phase 1, et ses composantes $\theta_n$ et $\mu_n$; cf
+// `src/detail/multivariate.hpp` pour les facteurs multidimensionnels.
+inline auto make_phase1_state(double xi, double theta, double mu) -> state<3> {
+    return make_state(xi, theta, mu);
+}
+
+inline auto phase1_theta(const state<3> & s) -> double {
+    return s[1];
+}
+
+inline auto phase1_mu(const state<3> & s) -> double {
+    return s[2];
+}
+
+// Vrai si le pas `l3` fait évoluer $\theta_n$.
+inline auto nonzero(double v) -> bool {
+    return v != 0;
+}
+
+// Vrai si le pas `v` est fini, cf `IS_metrics`.
+inline auto finite(double v) -> bool {
+    return std::isfinite(v);
+}
+
+// Surveillance de la phase 1 pour `switching::adaptive` (cf `src/switching.hpp`). Le niveau de
+// confiance adaptatif parcourt les niveaux 0.5, 0.8 puis `alpha` (en sautant ceux qui dépassent
+// `alpha`). On découpe la trajectoire en fenêtres d'au moins `window` pas, contenant au moins
+// `min_hits` tirages tombés dans la queue ($\phi(X - \theta_n) \geq \xi_n$, c'est-à-dire
+// $L3 \neq 0$): seuls ces tirages font évoluer $\theta_n$, et sans eux la trajectoire paraît
+// stable à tort. On compare les moyennes de $\theta_n$ et $\mu_n$ sur deux fenêtres
+// consécutives: une fenêtre est stable si ces moyennes varient de moins de `tolerance` en
+// relatif (par rapport à `max(|moyenne|, 1)`). Après `stable_windows` fenêtres stables
+// consécutives, on passe au niveau suivant; au dernier niveau, la phase 1 est terminée.
+// Comme avec `switching::fixed`, chaque niveau dispose d'au plus une part égale des `max_steps`
+// pas de la phase: si la queue est trop rarement atteinte pour conclure, on passe au niveau
+// suivant (ou à la phase 2) une fois cette part épuisée.
+class phase1_monitor {
+    private:
+        std::vector<double> levels;
+        std::size_t level = 0;
+        int window, min_hits, stable_windows, max_steps;
+        double tol;
+
+        int steps = 0, level_start = 0, count = 0, hits = 0, stable = 0;
+        double theta_sum = 0, mu_sum = 0;
+        double theta_mean = 0, mu_mean = 0;
+        bool has_mean = false, finished = false;
+        std::vector<int> switches;
+
+        auto close(double previous, double current) const -> bool {
+            auto scale = std::max(std::abs(current), 1.);
+            return std::abs(current - previous) <= tol * scale;
+        }
+
+        void next_level() {
+            switches.push_back(steps);
+            if (level + 1 < levels.size())
+                ++level;
+            else
+                finished = true;
+            level_start = steps;
+            theta_sum = mu_sum = 0;
+            count = hits = stable = 0;
+            has_mean = false;
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `alpha`: niveau de confiance visé
+        // * `max_steps`: nombre maximal de pas de la phase 1
+        // * `window`, `tolerance`, `min_hits`, `stable_windows`: cf plus haut
+        phase1_monitor(
+            double alpha,
+            int max_steps,
+            int window,
+            double tolerance = 0.02,
+            int min_hits = 10,
+            int stable_windows = 3
+        ) :
+            window { std::max(window, 1) }, min_hits { min_hits },
+            stable_windows { std::max(stable_windows, 1) }, max_steps { max_steps },
+            tol { tolerance }
+        {
+            if (alpha > 0.5)
+                levels.push_back(0.5);
+            if (alpha > 0.8)
+                levels.push_back(0.8);
+            levels.push_back(alpha);
+        }
+
+        // Niveau de confiance du pas en cours.
+        auto alpha() const -> double {
+            return levels[level];
+        }
+
+        // À appeler après chaque pas de la phase 1, avec les nouvelles valeurs de $\theta_n$ et
+        // $\mu_n$ et le fait que le tirage est tombé dans la queue ou non.
+        void record(double theta, double mu, bool hit) {
+            ++steps;
+            if (steps >= max_steps)
+                finished = true;
+            if (steps - level_start >= max_steps / static_cast<int>(levels.size())) {
+                next_level();
+                return;
+            }
+            theta_sum += theta;
+            mu_sum += mu;
+            hits += hit;
+            ++count;
+            if (count < window || hits < min_hits)
+                return;
+
+            auto theta_current = theta_sum / count;
+            auto mu_current = mu_sum / count;
+            auto steady = has_mean && hits >= min_hits && close(theta_mean, theta_current)
+                && close(mu_mean, mu_current);
+            theta_mean = theta_current;
+            mu_mean = mu_current;
+            has_mean = true;
+            theta_sum = mu_sum = 0;
+            count = hits = 0;
+
+            stable = steady ? stable + 1 : 0;
+            if (stable >= stable_windows)
+                next_level();
+        }
+
+        // Vrai lorsque l'on doit passer à la phase 2.
+        auto done() const -> bool {
+            return finished;
+        }
+
+        // Nombre de pas de la phase 1 effectués.
+        auto iterations() const -> int {
+            return steps;
+        }
+
+        // Nombres de pas après lesquels on a quitté chaque niveau.
+        auto level_switches() const -> const std::vector<int> & {
+            return switches;
+        }
+};
+
 // Phase 1 de l'algorithme d'importance sampling: calcule une première estimation
 // de (\xi_\alpha^*, \theta^*, \mu^*) en faisant `M` itérations avec un niveau `alpha`
-// adaptatif.
+// adaptatif. Si l'on fournit un `phase1_monitor`, c'est lui qui fixe le niveau de chaque pas, et
+// `M` n'est plus utilisé.
 template<class Phi, class Gamma, class Distribution, class Generator>
 class IS_phase1_sequence {
     private:
         const Phi & phi;
-        using input_type = decltype(phi(0));
+        using input_type = typename Distribution::result_type;
 
         double alpha, a, xi = 0;
         input_type theta { }, mu { };
         const Gamma & gamma;
         int M;
         int n = 0;
+        phase1_monitor * monitor;
+        IS_metrics * metrics;
 
-        Distribution & d;
-        Generator & g;
+        sampler<Distribution, Generator> sample;
         IS_params<Distribution> params;
 
     public:
-        using result_type = std::tuple<double, double, double>;
+        // `state<3>` pour des tirages scalaires, `factors_state` pour des facteurs.
+        using result_type = decltype(make_phase1_state(
+            0.,
+            std::declval<input_type>(),
+            std::declval<input_type>()
+        ));
 
         // Paramètres du constructeur:
         // * `alpha`, `phi`, `gamma`, `d`, `g`: cf les paramètres de
@@ -67,6 +231,9 @@ class IS_phase1_sequence {
         // * `a`: constante dams le contrôle exponentiel de $x \longmapsto \phi^2(x)$
         // * `M`: nombre d'itérations pour cette phase, à connaître pour régler le seuil
         //   `alpha`
+        // * `monitor`: surveillance de la phase avec `switching::adaptive`, ou `nullptr`;
+        //   partagée par les copies de la suite
+        // * `metrics`: mesures (cf `src/metrics.hpp`), ou `nullptr`; partagées de même
         IS_phase1_sequence(
             double alpha,
             double a,
@@ -74,11 +241,15 @@ class IS_phase1_sequence {
             const Gamma & gamma,
             int M,
             Distribution & d,
-            Generator & g
+            Generator & g,
+            phase1_monitor * monitor = nullptr,
+            IS_metrics * metrics = nullptr
         ) :
-            alpha { alpha }, a { a }, phi { phi }, gamma { gamma }, M { M }, d { d },
-            g { g }, params { d }
+            alpha { alpha }, a { a }, phi { phi }, gamma { gamma }, M { M }, monitor { monitor },
+            metrics { metrics }, sample { d, g }, params { d }
         {
+            theta = params.zero();
+            mu = params.zero();
         }
 
         // Chaque appel à `next` renvoie la valeur suivante de la suite
@@ -87,25 +258,67 @@ class IS_phase1_sequence {
         auto next() -> result_type {
             if (n == 0) {
                 ++n;
-                return std::make_tuple(xi, theta, mu);
+                return make_phase1_state(xi, theta, mu);
             }
             
             // Niveau de confiance adaptatif
             double alpha_n;
             int treshold = M / 3;
-            if (alpha > 0.5 && n <= treshold)
+            if (monitor != nullptr)
+                alpha_n = monitor->alpha();
+            else if (alpha > 0.5 && n <= treshold)
                 alpha_n = 0.5;
             else if (alpha > 0.8 && n <= 2 * treshold)
                 alpha_n = 0.8;
             else
                 alpha_n = alpha;
 
-            auto x = d(g);
-            theta -= gamma(n) * L3(xi, theta, x, phi, params);
-            mu -= gamma(n) * L4(xi, mu, x, a, phi, params);
-            xi -= gamma(n) * H1(xi, x, alpha_n);
+            auto x = sample();
+            auto step = gamma(n);
+            auto l3 = L3(xi, theta, x, phi, params);
+            auto l4 = L4(xi, mu, x, a, phi, params);
+            if (metrics != nullptr)
+                metrics->phase1_step(nonzero(l3), !finite(l3) || !finite(l4));
+            theta -= step * l3;
+            mu -= step * l4;
+            xi -= step * H1(xi, phi(x), alpha_n);
             ++n;
-            return std::make_tuple(xi, theta, mu);
+            auto result = make_phase1_state(xi, theta, mu);
+            if (monitor != nullptr)
+                monitor->record(result[1], result[2], nonzero(l3));
+            return result;
+        }
+
+        // Sauvegarde et restauration de l'état complet, cf `src/checkpoint.hpp`.
+        void save(std::ostream & os) const {
+            os << n << ' ' << xi << ' ' << theta << ' ' << mu << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> n >> xi >> theta >> mu;
+            sample.load(is);
+        }
+};
+
+// Observateur de la phase 1 avec `switching::adaptive`: transmet chaque terme à `observer`, et
+// demande l'arrêt dès que `monitor` a jugé la phase terminée.
+template<class Observer>
+class phase1_observer {
+    private:
+        Observer & observer;
+        const phase1_monitor & monitor;
+
+    public:
+        phase1_observer(Observer & observer, const phase1_monitor & monitor) :
+            observer(observer), monitor(monitor)
+        {
+        }
+
+        template<class State>
+        auto operator ()(int n, const State & state) -> bool {
+            auto go_on = observer(n, state);
+            return go_on && !monitor.done();
         }
 };
 
@@ -117,9 +330,9 @@ auto L1(
     const InputType & x,
     double alpha,
     const Phi & phi,
-    IS_params<Distribution> p
+    const IS_params<Distribution> & p
 ) -> double {
-    auto factor = std::exp(-p.rho() * std::pow(std::abs(theta), p.b()));
+    auto factor = std::exp(-p.rho() * std::pow(p.norm(theta), p.b()));
     if (phi(x + theta) < xi)
         return factor;
     return factor * (1 - 1 / (1 - alpha) * p.incr(x, theta));
@@ -134,7 +347,7 @@ auto L2(
     const InputType & x,
     double alpha,
     const Phi & phi,
-    IS_params<Distribution> p
+    const IS_params<Distribution> & p
 ) -> double {
     auto result = C - xi;
     auto val = phi(x + mu);
@@ -151,24 +364,25 @@ template<class Phi, class Gamma, class Distribution, class Generator>
 class IS_phase2_sequence {
     private:
         const Phi & phi;
-        using input_type = decltype(phi(0));
+        using input_type = typename Distribution::result_type;
 
         double alpha, xi, C = 0;
         input_type theta, mu;
         const Gamma & gamma;
         int n = 0;
+        IS_metrics * metrics;
 
-        Distribution & d;
-        Generator & g;
+        sampler<Distribution, Generator> sample;
         IS_params<Distribution> params;
 
     public:
-        using result_type = std::tuple<double, double>;
+        using result_type = state<2>;
 
         // Paramètres du constructeur:
         // * `alpha`, `phi`, `gamma`, `d`, `g`: cf les paramètres de
         //   `src/detail/stochastic_gradient.hpp/approx_sequence::approx_sequence`
         // * `xi`, `theta`, `mu`: valeurs estimées dans la phase 1
+        // * `metrics`: cf `IS_phase1_sequence::IS_phase1_sequence`
         IS_phase2_sequence(
             double alpha,
             double xi,
@@ -177,10 +391,11 @@ class IS_phase2_sequence {
             const Phi & phi,
             const Gamma & gamma,
             Distribution & d,
-            Generator & g
+            Generator & g,
+            IS_metrics * metrics = nullptr
         ) :
             alpha { alpha }, xi { xi }, theta { theta }, mu { mu }, phi { phi },
-            gamma { gamma }, d { d }, g { g }, params { d }
+            gamma { gamma }, metrics { metrics }, sample { d, g }, params { d }
         {
         }
 
@@ -189,14 +404,28 @@ class IS_phase2_sequence {
         auto next() -> result_type {
             if (n == 0) {
                 ++n;
-                return std::make_tuple(xi, C);
+                return make_state(xi, C);
             }
 
-            auto x = d(g);
-            C -= gamma(n) * L2(xi, C, mu, x, alpha, phi, params);
-            xi -= gamma(n) * L1(xi, theta, x, alpha, phi, params);
+            auto x = sample();
+            if (metrics != nullptr)
+                metrics->phase2_step(phi(x + theta) >= xi, params.incr(x, theta));
+            auto step = gamma(n);
+            C -= step * L2(xi, C, mu, x, alpha, phi, params);
+            xi -= step * L1(xi, theta, x, alpha, phi, params);
             ++n;
-            return std::make_tuple(xi, C);
+            return make_state(xi, C);
+        }
+
+        // Cf `IS_phase1_sequence::save` et `IS_phase1_sequence::load`.
+        void save(std::ostream & os) const {
+            os << n << ' ' << xi << ' ' << C << ' ' << theta << ' ' << mu << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> n >> xi >> C >> theta >> mu;
+            sample.load(is);
         }
 };
 
@@ -1,8 +1,11 @@
 #ifndef DETAIL_IMPORTANCE_SAMPLING_PARAMETERS_HPP
 #define DETAIL_IMPORTANCE_SAMPLING_PARAMETERS_HPP
 
+#include "multivariate.hpp"
+#include "../qmc.hpp"
+#include "../multivariate.hpp"
 #include <random>
-#include <cmath> // `std::exp`
+#include <cmath> // `std::exp`, `std::abs`, `std::sqrt`
 
 namespace detail {
 
@@ -14,16 +17,17 @@ namespace detail {
 // * $(x, \theta) \longmapsto \frac{p^2(x-\theta)}{p(x)p(x-2\theta)} \frac{\nabla p(x-2\theta)}{p(x-2\theta)}}$,
 //   qui intervient dans le gradient des fonctions à optimiser $Q_1$ et $Q_2$, représentée ici
 //   par la méthode `W`
+// * la norme $|\theta|$ qui intervient dans les facteurs $e^{-\rho |\theta|^b}$, représentée
+//   ici par la méthode `norm`
+// * le point de départ $\theta_0 = \mu_0 = 0$, représenté ici par la méthode `zero`
 template<class Distribution>
 class IS_params {
     private:
         const Distribution & d;
 
-        // Type inference hack: permet de récupérer le type de retour de la distribution
-        // choisie sans avoir à rajouter un paramètre template supplémentaire. Pourrait
-        // être utile notamment pour spécialiser avec des distributions à valeurs
-        // multi-dimensionnelles.
-        using input_type = decltype(d(std::mt19937 { std::random_device { }() }));
+        // Type des tirages, et donc de $\theta$ et $\mu$: `double` pour les lois usuelles,
+        // `factors` pour `gaussian_factors`.
+        using input_type = typename Distribution::result_type;
 
     public:
         IS_params(const Distribution & d) : d { d }
@@ -43,7 +47,15 @@ class IS_params {
             static_assert(d == d, "distribution not supported");
         }
 
-        auto W(const input_type & x, const input_type & theta) const -> double {
+        auto W(const input_type & x, const input_type & theta) const -> input_type {
+            static_assert(d == d, "distribution not supported");
+        }
+
+        auto norm(const input_type & theta) const -> double {
+            static_assert(d == d, "distribution not supported");
+        }
+
+        auto zero() const -> input_type {
             static_assert(d == d, "distribution not supported");
         }
 };
@@ -83,6 +95,14 @@ class IS_params<std::normal_distribution<>> {
             auto q = theta / stddev;
             return std::exp(q * q) * (2 * theta - x + mu);
         }
+
+        auto norm(const double & theta) const -> double {
+            return std::abs(theta);
+        }
+
+        auto zero() const -> double {
+            return 0;
+        }
 };
 
 template<>
@@ -116,6 +136,120 @@ class IS_params<std::exponential_distribution<>> {
                 return 2 * d.lambda() * std::exp(-2 * d.lambda() * (x - 2 * theta));
             return -2 * d.lambda();
         }
+
+        auto norm(const double & theta) const -> double {
+            return std::abs(theta);
+        }
+
+        auto zero() const -> double {
+            return 0;
+        }
+};
+
+// Paramètres pour la loi `gaussian_factors` $\mathcal{N}(m, \Sigma)$, $\Sigma = L L^T$, avec
+// $P = \Sigma^{-1}$ et $y = x - m$:
+// * $b = 2$, $\rho = \frac{1}{2}$ et $|\theta|^2 = \theta^T P \theta = |L^{-1} \theta|^2$
+//   (ce qui redonne $\rho |\theta|^b = \frac{\theta^2}{2 \sigma^2}$ en dimension 1)
+// * $\frac{p(x + \theta)}{p(x)} = e^{-\theta^T P y - \frac{1}{2} \theta^T P \theta}$
+// * le gradient vaut $e^{\theta^T P \theta} P (2\theta - y)$; comme pour la loi normale en
+//   dimension 1 (où l'on omet le facteur $\frac{1}{\sigma^2}$), `W` le multiplie par
+//   $\Sigma$, ce qui ne change pas ses zéros et préconditionne la descente: il reste
+//   $e^{\theta^T P \theta} (2\theta - y)$.
+// Les produits par $P$ se ramènent à des descentes triangulaires par $L$
+// (`gaussian_factors::whiten`), en $O(d^2)$. On garde les derniers résultats dans des tampons
+// propres à l'objet: $L^{-1} \theta$ pour les deux derniers décalages (en phase 2, $\theta$ et
+// $\mu$ sont fixes et reviennent à chaque pas) et $L^{-1} y$ pour le dernier tirage (partagé
+// par les deux appels à `incr` d'un même pas). Il ne reste alors que des boucles en $O(d)$.
+template<>
+class IS_params<gaussian_factors> {
+    private:
+        const gaussian_factors & d;
+        mutable factors shifts[2], whitened_shifts[2];
+        mutable int last = 0;
+        mutable factors sample, whitened_sample;
+
+        // $L^{-1} \theta$.
+        auto whiten_shift(const factors & theta) const -> const factors & {
+            for (int k = 0; k < 2; ++k)
+                if (shifts[k] == theta)
+                    return whitened_shifts[k];
+            last = 1 - last;
+            shifts[last] = theta;
+            d.whiten(theta.data(), whitened_shifts[last].data());
+            return whitened_shifts[last];
+        }
+
+        // $L^{-1} (x - m)$.
+        auto whiten_sample(const factors & x) const -> const factors & {
+            if (!(sample == x)) {
+                sample = x;
+                const auto & m = d.mean();
+                for (std::size_t i = 0; i < x.size(); ++i)
+                    whitened_sample[i] = x[i] - m[i];
+                d.whiten(whitened_sample.data(), whitened_sample.data());
+            }
+            return whitened_sample;
+        }
+
+    public:
+        IS_params(const gaussian_factors & d) :
+            d(d), whitened_shifts { factors(d.dimension()), factors(d.dimension()) },
+            whitened_sample(d.dimension())
+        {
+        }
+
+        auto b() const -> double {
+            return 2;
+        }
+
+        auto rho() const -> double {
+            return 0.5;
+        }
+
+        auto incr(const factors & x, const factors & theta) const -> double {
+            const auto & s = whiten_shift(theta);
+            const auto & z = whiten_sample(x);
+            return std::exp(-dot(s, z) - 0.5 * dot(s, s));
+        }
+
+        auto W(const factors & x, const factors & theta) const -> factors {
+            const auto & s = whiten_shift(theta);
+            auto scale = std::exp(dot(s, s));
+            const auto & m = d.mean();
+            factors result(x.size());
+            for (std::size_t i = 0; i < x.size(); ++i)
+                result[i] = scale * (2 * theta[i] - x[i] + m[i]);
+            return result;
+        }
+
+        auto norm(const factors & theta) const -> double {
+            const auto & s = whiten_shift(theta);
+            return std::sqrt(dot(s, s));
+        }
+
+        auto zero() const -> factors {
+            return factors(d.dimension());
+        }
+};
+
+// Les lois de `src/qmc.hpp` ne diffèrent des lois usuelles que par la façon de tirer.
+template<>
+class IS_params<qmc::normal_distribution> : public IS_params<std::normal_distribution<>> {
+    public:
+        IS_params(const qmc::normal_distribution & d) : IS_params<std::normal_distribution<>> { d }
+        {
+        }
+};
+
+template<>
+class IS_params<qmc::exponential_distribution> :
+    public IS_params<std::exponential_distribution<>>
+{
+    public:
+        IS_params(const qmc::exponential_distribution & d) :
+            IS_params<std::exponential_distribution<>> { d }
+        {
+        }
 };
 
 }
@@ -11,12 +11,39 @@ auto iterate(
     int iterations
 ) -> typename Sequence::result_type
 {
-    typename Sequence::result_type state;
+    typename Sequence::result_type state {};
     for (int n = 0; n < iterations; ++n)
         state = sequence.next();
     return state;
 }
 
+// Observateur par défaut pour la fonction suivante: ne fait rien et ne demande jamais l'arrêt.
+struct no_observer {
+    template<class State>
+    auto operator ()(int, const State &) -> bool {
+        return true;
+    }
+};
+
+// Variante de la fonction précédente où l'on appelle `observer(n, state)` après le calcul de
+// chaque terme; si l'observateur renvoie `false`, on s'arrête et on renvoie le terme courant.
+// Le paramètre `iterations` devient alors un nombre maximal d'itérations.
+template<class Sequence, class Observer>
+auto iterate(
+    Sequence sequence,
+    int iterations,
+    Observer & observer
+) -> typename Sequence::result_type
+{
+    typename Sequence::result_type state {};
+    for (int n = 0; n < iterations; ++n) {
+        state = sequence.next();
+        if (!observer(n, state))
+            break;
+    }
+    return state;
+}
+
 }
 
 #endif
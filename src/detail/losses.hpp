@@ -0,0 +1,121 @@
+#ifndef DETAIL_LOSSES_HPP
+#define DETAIL_LOSSES_HPP
+
+#include "sampler.hpp"
+#include <vector>
+#include <cstddef> // `std::size_t`
+#include <type_traits> // `std::true_type`, `std::false_type`
+#include <utility> // `std::declval`
+#include <istream>
+#include <ostream>
+
+namespace detail {
+
+// Vaut `true` si `Phi` offre une évaluation par blocs `phi.evaluate(x, out, n)` (cf
+// `src/losses.hpp`), `false` sinon (fonctions et lambdas usuelles).
+template<class Phi, class = void>
+struct has_batch : std::false_type {
+};
+
+template<class Phi>
+struct has_batch<Phi, decltype(std::declval<const Phi &>().evaluate(
+    std::declval<const double *>(),
+    std::declval<double *>(),
+    std::size_t { }
+))> : std::true_type {
+};
+
+// Source de réalisations de $\phi(X)$, utilisée par les suites qui n'ont besoin que de la perte
+// et pas du tirage lui-même. Cas général: on appelle `phi(sample())` à chaque tirage.
+template<class Phi, class Distribution, class Generator, bool Batch = has_batch<Phi>::value>
+class loss_sampler {
+    private:
+        const Phi & phi;
+        sampler<Distribution, Generator> sample;
+
+    public:
+        loss_sampler(const Phi & phi, Distribution & d, Generator & g) : phi(phi), sample { d, g }
+        {
+        }
+
+        auto operator ()() -> double {
+            return phi(sample());
+        }
+
+        // Écrit `n` réalisations dans `out`.
+        void fill(double * out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = phi(sample());
+        }
+
+        // Cf `sampler::save` et `sampler::load`.
+        void save(std::ostream & os) const {
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            sample.load(is);
+        }
+};
+
+// Cas d'une fonction de perte évaluable par blocs: on tire `sampler_block` réalisations de $X$
+// d'un coup, on les passe à `phi.evaluate`, puis on distribue les pertes une à une.
+template<class Phi, class Distribution, class Generator>
+class loss_sampler<Phi, Distribution, Generator, true> {
+    private:
+        const Phi & phi;
+        sampler<Distribution, Generator> sample;
+        std::vector<double> samples, losses;
+        std::size_t index = sampler_block;
+
+        void refill() {
+            sample.fill(samples.data(), sampler_block);
+            phi.evaluate(samples.data(), losses.data(), sampler_block);
+            index = 0;
+        }
+
+    public:
+        loss_sampler(const Phi & phi, Distribution & d, Generator & g) :
+            phi(phi), sample { d, g }, samples(sampler_block), losses(sampler_block)
+        {
+        }
+
+        auto operator ()() -> double {
+            if (index == sampler_block)
+                refill();
+            return losses[index++];
+        }
+
+        void fill(double * out, std::size_t n) {
+            while (n > 0) {
+                if (index == sampler_block)
+                    refill();
+                auto count = sampler_block - index < n ? sampler_block - index : n;
+                for (std::size_t i = 0; i < count; ++i)
+                    out[i] = losses[index + i];
+                index += count;
+                out += count;
+                n -= count;
+            }
+        }
+
+        // Pertes du bloc courant non encore consommées, puis état de `sample`.
+        void save(std::ostream & os) const {
+            os << index;
+            for (auto i = index; i < sampler_block; ++i)
+                os << ' ' << losses[i];
+            os << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> index;
+            for (auto i = index; i < sampler_block; ++i)
+                is >> losses[i];
+            sample.load(is);
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef DETAIL_MULTI_LEVEL_HPP
+#define DETAIL_MULTI_LEVEL_HPP
+
+#include "losses.hpp"
+#include <vector>
+#include <cstddef> // `std::size_t`
+#include <algorithm> // `std::max`
+
+namespace detail {
+
+// Valeurs courantes des suites $(\xi^k_n, C^k_n)$ pour plusieurs niveaux de confiance
+// $\alpha_k$, rangées par composante (un tableau contigu pour les $\xi^k$, un pour les $C^k$)
+// pour que les mises à jour de tous les niveaux se fassent dans une boucle vectorisable.
+struct levels_state {
+    std::vector<double> xi, C;
+};
+
+// Variante de `approx_sequence` (cf `src/detail/stochastic_gradient.hpp`) qui fait évoluer
+// simultanément une suite $(\xi^k_n, C^k_n)$ par niveau de confiance $\alpha_k$, toutes les
+// suites utilisant le même tirage $X$ et la même évaluation de $\phi(X)$ à chaque pas.
+// Si `avg == true`, on applique de plus la moyennisation de Ruppert et Polyak directement
+// sur les tableaux, plutôt que via `src/detail/averaging.hpp` qui ferait une copie de l'état
+// à chaque itération.
+template<class Phi, class Gamma, class Distribution, class Generator>
+class levels_sequence {
+    private:
+        const Gamma & gamma;
+        bool avg;
+        int n = 0;
+
+        // $\frac{1}{1 - \alpha_k}$ pour chaque niveau
+        std::vector<double> inv;
+        levels_state state, avg_state;
+
+        loss_sampler<Phi, Distribution, Generator> sample;
+
+    public:
+        using result_type = levels_state;
+
+        // Paramètres du constructeur:
+        // * `alphas`: niveaux de confiance
+        // * `phi`, `gamma`, `d`, `g`: cf `approx_sequence::approx_sequence`
+        // * `avg`: appliquer ou non la moyennisation de Ruppert et Polyak
+        levels_sequence(
+            const std::vector<double> & alphas,
+            const Phi & phi,
+            const Gamma & gamma,
+            bool avg,
+            Distribution & d,
+            Generator & g
+        ) :
+            gamma { gamma }, avg { avg }, inv(alphas.size()),
+            state { std::vector<double>(alphas.size()), std::vector<double>(alphas.size()) },
+            avg_state(state), sample { phi, d, g }
+        {
+            for (std::size_t k = 0; k < alphas.size(); ++k)
+                inv[k] = 1 / (1 - alphas[k]);
+        }
+
+        // Chaque appel à `next` fait avancer toutes les suites d'un pas et renvoie une référence
+        // vers leurs valeurs courantes (moyennisées si `avg == true`), valable jusqu'au
+        // prochain appel.
+        auto next() -> const result_type & {
+            if (n == 0) {
+                ++n;
+                return state;
+            }
+
+            double x = sample();
+            auto step = gamma(n);
+            auto levels = inv.size();
+            auto xi = state.xi.data();
+            auto C = state.C.data();
+            for (std::size_t k = 0; k < levels; ++k) {
+                // Cf `H1` et `v` dans `src/detail/stochastic_gradient.hpp`.
+                auto tail = x < xi[k] ? 0. : inv[k];
+                auto v = xi[k] + inv[k] * std::max(x - xi[k], 0.0);
+                C[k] -= step * (C[k] - v);
+                xi[k] -= step * (1 - tail);
+            }
+
+            if (!avg) {
+                ++n;
+                return state;
+            }
+
+            // Comme dans `src/detail/averaging.hpp`, on moyennise les termes à partir du premier
+            // pas (l'état initial n'est pas pris en compte).
+            auto weight = 1 / static_cast<double>(n);
+            auto avg_xi = avg_state.xi.data();
+            auto avg_C = avg_state.C.data();
+            for (std::size_t k = 0; k < levels; ++k) {
+                avg_xi[k] -= (avg_xi[k] - xi[k]) * weight;
+                avg_C[k] -= (avg_C[k] - C[k]) * weight;
+            }
+            ++n;
+            return avg_state;
+        }
+};
+
+}
+
+#endif
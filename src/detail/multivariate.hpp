@@ -0,0 +1,131 @@
+#ifndef DETAIL_MULTIVARIATE_HPP
+#define DETAIL_MULTIVARIATE_HPP
+
+#include "sampler.hpp"
+#include "state.hpp"
+#include "../multivariate.hpp"
+#include <random>
+#include <cmath> // `std::sqrt`, `std::isfinite`
+#include <istream>
+#include <ostream>
+
+namespace detail {
+
+// Loi normale centrée réduite partagée par les `sampler<gaussian_factors, *>`: les blocs de
+// `sampler<std::normal_distribution<>, *>` ne font que lire ses paramètres.
+inline auto standard_normal() -> std::normal_distribution<> & {
+    static std::normal_distribution<> unit;
+    return unit;
+}
+
+// Loi `gaussian_factors`: les normales centrées réduites sont tirées par blocs (cf
+// `sampler<std::normal_distribution<>, *>`), puis corrélées par `gaussian_factors::correlate`.
+template<class Generator>
+class sampler<gaussian_factors, Generator> {
+    private:
+        const gaussian_factors & d;
+        sampler<std::normal_distribution<>, Generator> normals;
+        factors z;
+
+    public:
+        using result_type = factors;
+
+        sampler(gaussian_factors & d, Generator & g) :
+            d(d), normals { standard_normal(), g }, z(d.dimension())
+        {
+        }
+
+        auto operator ()() -> factors {
+            factors x(d.dimension());
+            for (std::size_t i = 0; i < z.size(); ++i)
+                z[i] = normals();
+            d.correlate(z.data(), x.data());
+            return x;
+        }
+
+        void fill(factors * out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = (*this)();
+        }
+
+        void save(std::ostream & os) const {
+            normals.save(os);
+        }
+
+        void load(std::istream & is) {
+            normals.load(is);
+        }
+};
+
+// Terme de la phase 1 de l'importance sampling avec des facteurs (cf
+// `src/detail/importance_sampling.hpp/IS_phase1_sequence`): $\xi_n$, $\theta_n$ et $\mu_n$.
+// Pour les observateurs, qui attendent des flottants, les composantes 1 et 2 sont les normes
+// euclidiennes de $\theta_n$ et $\mu_n$.
+struct factors_state {
+    double xi;
+    factors theta, mu;
+
+    auto operator [](std::size_t i) const -> double {
+        if (i == 0)
+            return xi;
+        return std::sqrt(i == 1 ? dot(theta, theta) : dot(mu, mu));
+    }
+
+    auto operator +=(const factors_state & r) -> factors_state & {
+        xi += r.xi;
+        theta += r.theta;
+        mu += r.mu;
+        return *this;
+    }
+
+    auto operator /=(double r) -> factors_state & {
+        xi /= r;
+        theta /= r;
+        mu /= r;
+        return *this;
+    }
+};
+
+// Cf `src/detail/importance_sampling.hpp/make_phase1_state` et les fonctions suivantes.
+inline auto make_phase1_state(
+    double xi,
+    const factors & theta,
+    const factors & mu
+) -> factors_state {
+    return factors_state { xi, theta, mu };
+}
+
+inline auto phase1_theta(const factors_state & s) -> const factors & {
+    return s.theta;
+}
+
+inline auto phase1_mu(const factors_state & s) -> const factors & {
+    return s.mu;
+}
+
+inline auto nonzero(const factors & v) -> bool {
+    for (std::size_t i = 0; i < v.size(); ++i)
+        if (v[i] != 0)
+            return true;
+    return false;
+}
+
+inline auto finite(const factors & v) -> bool {
+    for (std::size_t i = 0; i < v.size(); ++i)
+        if (!std::isfinite(v[i]))
+            return false;
+    return true;
+}
+
+// Cf `src/detail/state.hpp/write` et `read`.
+inline void write(std::ostream & os, const factors_state & s) {
+    os << s.xi << ' ' << s.theta << ' ' << s.mu;
+}
+
+inline void read(std::istream & is, factors_state & s) {
+    is >> s.xi >> s.theta >> s.mu;
+}
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef DETAIL_PORTFOLIOS_HPP
+#define DETAIL_PORTFOLIOS_HPP
+
+#include "multi_level.hpp"
+#include "losses.hpp"
+#include "sampler.hpp"
+#include <vector>
+#include <cstddef> // `std::size_t`
+#include <algorithm> // `std::max`
+#include <type_traits> // `std::true_type`, `std::false_type`
+
+namespace detail {
+
+// Variante de `levels_sequence` pour plusieurs fonctions de perte $\phi_p$ (par exemple les
+// sous-portefeuilles d'un même livre) et un seul niveau de confiance: une suite
+// $(\xi^p_n, C^p_n)$ par fonction de perte, toutes les suites utilisant le même tirage $X$ à
+// chaque pas. Les valeurs courantes sont rangées par composante (cf `levels_state`).
+// Les tirages sont faits par blocs de `sampler_block`; les pertes du bloc sont rangées tirage
+// par tirage (les $P$ pertes d'un même tirage sont contiguës), pour que la mise à jour des $P$
+// suites à chaque pas soit une boucle vectorisable. Si `Phi` offre une évaluation par blocs
+// (cf `src/losses.hpp`), chaque fonction de perte est évaluée sur tout le bloc d'un coup.
+// Chaque suite prend exactement les valeurs de la suite `approx_sequence` de même fonction de
+// perte, avec le même générateur.
+template<class Phi, class Gamma, class Distribution, class Generator>
+class portfolios_sequence {
+    private:
+        using input_type = typename Distribution::result_type;
+
+        const std::vector<Phi> & phis;
+        const Gamma & gamma;
+        double inv; // $\frac{1}{1 - \alpha}$
+        bool avg;
+        int n = 0;
+
+        levels_state state, avg_state;
+
+        sampler<Distribution, Generator> sample;
+        std::vector<input_type> draws;
+        std::vector<double> losses, scratch;
+        std::size_t index = sampler_block;
+
+        // Pertes du bloc, évaluées par blocs.
+        void evaluate(std::true_type) {
+            auto count = phis.size();
+            for (std::size_t p = 0; p < count; ++p) {
+                phis[p].evaluate(draws.data(), scratch.data(), sampler_block);
+                for (std::size_t j = 0; j < sampler_block; ++j)
+                    losses[j * count + p] = scratch[j];
+            }
+        }
+
+        // Pertes du bloc, évaluées une à une.
+        void evaluate(std::false_type) {
+            auto count = phis.size();
+            for (std::size_t j = 0; j < sampler_block; ++j)
+                for (std::size_t p = 0; p < count; ++p)
+                    losses[j * count + p] = phis[p](draws[j]);
+        }
+
+        void refill() {
+            sample.fill(draws.data(), sampler_block);
+            evaluate(has_batch<Phi> { });
+            index = 0;
+        }
+
+    public:
+        using result_type = levels_state;
+
+        // Paramètres du constructeur:
+        // * `alpha`, `gamma`, `d`, `g`: cf `approx_sequence::approx_sequence`
+        // * `phis`: fonctions de perte
+        // * `avg`: appliquer ou non la moyennisation de Ruppert et Polyak
+        portfolios_sequence(
+            double alpha,
+            const std::vector<Phi> & phis,
+            const Gamma & gamma,
+            bool avg,
+            Distribution & d,
+            Generator & g
+        ) :
+            phis(phis), gamma(gamma), inv { 1 / (1 - alpha) }, avg { avg },
+            state { std::vector<double>(phis.size()), std::vector<double>(phis.size()) },
+            avg_state(state), sample { d, g }, draws(sampler_block),
+            losses(sampler_block * phis.size()), scratch(sampler_block)
+        {
+        }
+
+        // Cf `levels_sequence::next`.
+        auto next() -> const result_type & {
+            if (n == 0) {
+                ++n;
+                return state;
+            }
+
+            if (index == sampler_block)
+                refill();
+            const auto * loss = losses.data() + index * phis.size();
+            ++index;
+
+            auto step = gamma(n);
+            auto count = phis.size();
+            auto xi = state.xi.data();
+            auto C = state.C.data();
+            for (std::size_t p = 0; p < count; ++p) {
+                // Cf `H1` et `v` dans `src/detail/stochastic_gradient.hpp`.
+                auto tail = loss[p] < xi[p] ? 0. : inv;
+                auto v = xi[p] + inv * std::max(loss[p] - xi[p], 0.0);
+                C[p] -= step * (C[p] - v);
+                xi[p] -= step * (1 - tail);
+            }
+
+            if (!avg) {
+                ++n;
+                return state;
+            }
+
+            // Mêmes opérations que dans `src/detail/averaging.hpp`, pour retrouver exactement les
+            // valeurs moyennisées de `approx_kernel`.
+            auto avg_xi = avg_state.xi.data();
+            auto avg_C = avg_state.C.data();
+            for (std::size_t p = 0; p < count; ++p) {
+                avg_xi[p] += (xi[p] - avg_xi[p]) / n;
+                avg_C[p] += (C[p] - avg_C[p]) / n;
+            }
+            ++n;
+            return avg_state;
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef DETAIL_RING_HPP
+#define DETAIL_RING_HPP
+
+#include <atomic>
+#include <vector>
+#include <cstddef> // `std::size_t`
+
+namespace detail {
+
+// File circulaire bornée, sans verrou, à un seul producteur et un seul consommateur. Les cases
+// sont allouées une fois pour toutes et réutilisées: le producteur remplit sur place la case
+// renvoyée par `back` puis la publie avec `push`; le consommateur lit sur place la case
+// renvoyée par `front` puis la libère avec `pop`. `head` n'est écrit que par le consommateur et
+// `tail` que par le producteur (sur deux lignes de cache distinctes); la paire
+// `release`/`acquire` garantit que le contenu d'une case est visible avant sa publication.
+template<class T>
+class spsc_ring {
+    private:
+        std::vector<T> slots;
+        std::atomic<std::size_t> head { 0 }; // prochaine case à lire
+        char padding[64];
+        std::atomic<std::size_t> tail { 0 }; // prochaine case à écrire
+
+    public:
+        // Paramètres du constructeur:
+        // * `capacity`: nombre de cases
+        // * `value`: valeur initiale des cases
+        spsc_ring(std::size_t capacity, const T & value) : slots(capacity, value)
+        {
+        }
+
+        spsc_ring(const spsc_ring &) = delete;
+        auto operator =(const spsc_ring &) -> spsc_ring & = delete;
+
+        // Côté producteur: case libre suivante, ou `nullptr` si la file est pleine.
+        auto back() -> T * {
+            auto t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == slots.size())
+                return nullptr;
+            return &slots[t % slots.size()];
+        }
+
+        void push() {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Côté consommateur: case publiée suivante, ou `nullptr` si la file est vide.
+        auto front() -> T * {
+            auto h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire))
+                return nullptr;
+            return &slots[h % slots.size()];
+        }
+
+        void pop() {
+            head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef DETAIL_SAMPLER_HPP
+#define DETAIL_SAMPLER_HPP
+
+#include "vmath.hpp"
+#include "../random.hpp"
+#include <random>
+#include <vector>
+#include <cstddef> // `std::size_t`
+#include <cstdint>
+#include <limits>
+#include <cmath> // `std::sqrt`
+#include <istream>
+#include <ostream>
+
+namespace detail {
+
+// Taille des blocs de variables aléatoires générés d'un coup par `sampler`.
+constexpr std::size_t sampler_block = 256;
+
+// Tire un flottant uniforme dans $[0, 1[$ avec 53 bits aléatoires. Cas général: on passe
+// par `std::generate_canonical`.
+template<class Generator, bool Bits32 = Generator::min() == 0 && Generator::max() == 0xffffffffULL>
+struct uniform53 {
+    static auto draw(Generator & g) -> double {
+        return std::generate_canonical<double, std::numeric_limits<double>::digits>(g);
+    }
+};
+
+// Cas d'un générateur de mots de 32 bits (comme `std::mt19937`): on combine deux tirages, comme
+// la fonction `genrand_res53` de l'implémentation de référence du Mersenne Twister.
+template<class Generator>
+struct uniform53<Generator, true> {
+    static auto draw(Generator & g) -> double {
+        auto a = static_cast<std::uint32_t>(g()) >> 5;
+        auto b = static_cast<std::uint32_t>(g()) >> 6;
+        return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// Remplit `u` avec `n` flottants uniformes, équivalent à `n` appels à `uniform53::draw`.
+template<class Generator>
+void uniform_block(Generator & g, double * u, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        u[i] = uniform53<Generator>::draw(g);
+}
+
+// Cas du générateur à compteur: on génère d'abord tous les mots de 32 bits d'un coup.
+inline void uniform_block(philox4x32 & g, double * u, std::size_t n) {
+    std::uint32_t words[64];
+    while (n > 0) {
+        auto count = n < 32 ? n : 32;
+        g.generate(words, 2 * count);
+        for (std::size_t i = 0; i < count; ++i)
+            u[i] = ((words[2 * i] >> 5) * 67108864.0 + (words[2 * i + 1] >> 6))
+                * (1.0 / 9007199254740992.0);
+        u += count;
+        n -= count;
+    }
+}
+
+// Source de réalisations de la loi `Distribution`, utilisée par les suites de
+// `src/detail/stochastic_gradient.hpp` et `src/detail/importance_sampling.hpp` à la place
+// d'appels directs à `d(g)`. Cas général: on se contente d'appeler `d(g)` à chaque tirage.
+template<class Distribution, class Generator>
+class sampler {
+    private:
+        Distribution & d;
+        Generator & g;
+
+    public:
+        using result_type = typename Distribution::result_type;
+
+        sampler(Distribution & d, Generator & g) : d { d }, g { g }
+        {
+        }
+
+        auto operator ()() -> result_type {
+            return d(g);
+        }
+
+        // Écrit `n` réalisations dans `out`.
+        void fill(result_type * out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = d(g);
+        }
+
+        // Pas d'état propre: celui de `d` et `g` est sauvegardé à part, cf `src/checkpoint.hpp`.
+        void save(std::ostream &) const {
+        }
+
+        void load(std::istream &) {
+        }
+};
+
+// Base commune des spécialisations par blocs: les réalisations sont produites `sampler_block`
+// par `sampler_block` dans un tampon contigu par la méthode `Derived::transform`, qui
+// transforme un bloc de flottants uniformes en un bloc de réalisations de la loi voulue par une
+// boucle vectorisable. Les paramètres de la loi sont relus dans `d` à chaque bloc.
+template<class Derived, class Distribution, class Generator>
+class block_sampler {
+    private:
+        std::vector<double> uniforms, buffer;
+        std::size_t index = sampler_block;
+
+        void refill() {
+            uniform_block(g, uniforms.data(), uniforms.size());
+            static_cast<Derived &>(*this).transform(uniforms.data(), buffer.data());
+            index = 0;
+        }
+
+    protected:
+        Distribution & d;
+        Generator & g;
+
+    public:
+        using result_type = double;
+
+        block_sampler(Distribution & d, Generator & g) :
+            uniforms(sampler_block), buffer(sampler_block), d { d }, g { g }
+        {
+        }
+
+        auto operator ()() -> double {
+            if (index == sampler_block)
+                refill();
+            return buffer[index++];
+        }
+
+        void fill(double * out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = (*this)();
+        }
+
+        // Sauvegarde et restauration des réalisations du bloc courant non encore consommées.
+        void save(std::ostream & os) const {
+            os << index;
+            for (auto i = index; i < sampler_block; ++i)
+                os << ' ' << buffer[i];
+            os << '\n';
+        }
+
+        void load(std::istream & is) {
+            is >> index;
+            for (auto i = index; i < sampler_block; ++i)
+                is >> buffer[i];
+        }
+};
+
+// Loi normale: méthode de Box-Muller, deux uniformes donnent deux réalisations indépendantes.
+template<class Generator>
+class sampler<std::normal_distribution<>, Generator> :
+    public block_sampler<sampler<std::normal_distribution<>, Generator>, std::normal_distribution<>, Generator>
+{
+    private:
+        using base = block_sampler<sampler, std::normal_distribution<>, Generator>;
+        friend base;
+
+        void transform(const double * u, double * out) const {
+            auto mean = this->d.mean();
+            auto stddev = this->d.stddev();
+            for (std::size_t i = 0; i < sampler_block / 2; ++i) {
+                // `1 - u` est dans $]0, 1]$, donc le logarithme est bien défini.
+                auto radius = stddev * std::sqrt(-2 * fast_log(1 - u[i]));
+                double s, c;
+                sincos_2pi(u[i + sampler_block / 2], s, c);
+                out[i] = mean + radius * c;
+                out[i + sampler_block / 2] = mean + radius * s;
+            }
+        }
+
+    public:
+        sampler(std::normal_distribution<> & d, Generator & g) : base { d, g }
+        {
+        }
+};
+
+// Loi exponentielle: inversion de la fonction de répartition.
+template<class Generator>
+class sampler<std::exponential_distribution<>, Generator> :
+    public block_sampler<sampler<std::exponential_distribution<>, Generator>, std::exponential_distribution<>, Generator>
+{
+    private:
+        using base = block_sampler<sampler, std::exponential_distribution<>, Generator>;
+        friend base;
+
+        void transform(const double * u, double * out) const {
+            auto scale = -1 / this->d.lambda();
+            for (std::size_t i = 0; i < sampler_block; ++i)
+                out[i] = scale * fast_log(1 - u[i]);
+        }
+
+    public:
+        sampler(std::exponential_distribution<> & d, Generator & g) : base { d, g }
+        {
+        }
+};
+
+}
+
+#endif
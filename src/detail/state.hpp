@@ -0,0 +1,97 @@
+#ifndef DETAIL_STATE_HPP
+#define DETAIL_STATE_HPP
+
+#include <cstddef> // `std::size_t`
+#include <istream>
+#include <ostream>
+
+namespace detail {
+
+// Valeur courante d'une suite: `N` flottants contigus et alignés, par exemple $(\xi_n, C_n)$ ou
+// $(\xi_n, \theta_n, \mu_n)$. Les opérations terme à terme sont de simples boucles de longueur
+// connue à la compilation, que le compilateur déroule et vectorise; le type est trivialement
+// copiable et tient dans un ou deux registres vectoriels.
+//
+// On s'en sert comme `result_type` des suites, et pour la moyennisation de
+// `src/detail/averaging.hpp`.
+template<std::size_t N>
+struct alignas(16) state {
+    double values[N];
+
+    auto operator [](std::size_t i) -> double & {
+        return values[i];
+    }
+
+    auto operator [](std::size_t i) const -> const double & {
+        return values[i];
+    }
+
+    auto operator +=(const state & r) -> state & {
+        for (std::size_t i = 0; i < N; ++i)
+            values[i] += r.values[i];
+        return *this;
+    }
+
+    auto operator -=(const state & r) -> state & {
+        for (std::size_t i = 0; i < N; ++i)
+            values[i] -= r.values[i];
+        return *this;
+    }
+
+    auto operator *=(double r) -> state & {
+        for (std::size_t i = 0; i < N; ++i)
+            values[i] *= r;
+        return *this;
+    }
+
+    auto operator /=(double r) -> state & {
+        for (std::size_t i = 0; i < N; ++i)
+            values[i] /= r;
+        return *this;
+    }
+};
+
+// Équivalent de `std::make_tuple`: `make_state(xi, C)` est un `state<2>`.
+template<class... T>
+auto make_state(T... values) -> state<sizeof...(T)> {
+    return state<sizeof...(T)> { { static_cast<double>(values)... } };
+}
+
+// Addition et soustraction terme à terme, multiplication et division par un scalaire.
+template<std::size_t N>
+auto operator +(state<N> l, const state<N> & r) -> state<N> {
+    return l += r;
+}
+
+template<std::size_t N>
+auto operator -(state<N> l, const state<N> & r) -> state<N> {
+    return l -= r;
+}
+
+template<std::size_t N>
+auto operator *(state<N> l, double r) -> state<N> {
+    return l *= r;
+}
+
+template<std::size_t N>
+auto operator /(state<N> l, double r) -> state<N> {
+    return l /= r;
+}
+
+// Écriture et lecture des composantes, séparées par des espaces (pour les sauvegardes de
+// `src/checkpoint.hpp`).
+template<std::size_t N>
+void write(std::ostream & os, const state<N> & s) {
+    for (std::size_t i = 0; i < N; ++i)
+        os << (i == 0 ? "" : " ") << s[i];
+}
+
+template<std::size_t N>
+void read(std::istream & is, state<N> & s) {
+    for (std::size_t i = 0; i < N; ++i)
+        is >> s[i];
+}
+
+}
+
+#endif
@@ -1,7 +1,13 @@
 #ifndef DETAIL_STOCHASTIC_GRADIENT_HPP
 #define DETAIL_STOCHASTIC_GRADIENT_HPP
 
-#include <tuple>
+#include "sampler.hpp"
+#include "losses.hpp"
+#include "variance_reduction.hpp"
+#include "state.hpp"
+#include <vector>
+#include <istream>
+#include <ostream>
 #include <algorithm> // `std::max`
 
 namespace detail {
@@ -23,16 +29,15 @@ inline auto v(double xi, double x, double alpha) -> double {
 template<class Phi, class Gamma, class Distribution, class Generator>
 class approx_sequence {
     private:
-        const Phi & phi;
         double alpha, xi = 0, C = 0; // On choisit $\xi_0 = C_0 = 0$.
         const Gamma & gamma;
-        int n = 0;
+        long long n = 0; // sur 64 bits pour les sources de pertes de `src/stream.hpp`
 
-        Distribution & d;
-        Generator & g;
+        // Réalisations de $\phi(X)$, évaluées par blocs si `Phi` le permet.
+        loss_sampler<Phi, Distribution, Generator> sample;
 
     public:
-        using result_type = std::tuple<double, double>;
+        using result_type = state<2>;
 
         // Paramètres du constructeur:
         // * `alpha`, `phi`, `gamma`: cf les paramètres de
@@ -45,7 +50,7 @@ class approx_sequence {
             const Gamma & gamma,
             Distribution & d,
             Generator & g
-        ) : alpha { alpha }, phi { phi }, gamma { gamma }, d { d }, g { g }
+        ) : alpha { alpha }, gamma { gamma }, sample { phi, d, g }
         {
         }
 
@@ -54,14 +59,189 @@ class approx_sequence {
         auto next() -> result_type {
             if (n == 0) {
                 ++n;
-                return std::make_tuple(xi, C);
+                return make_state(xi, C);
             }
 
-            double x = phi(d(g));
-            C -= gamma(n) * (C - v(xi, x, alpha));
-            xi -= gamma(n) * H1(xi, x, alpha);
+            double x = sample();
+            auto step = gamma(n);
+            C -= step * (C - v(xi, x, alpha));
+            xi -= step * H1(xi, x, alpha);
             ++n;
-            return std::make_tuple(xi, C);
+            return make_state(xi, C);
+        }
+
+        // Sauvegarde et restauration de l'état complet, cf `src/checkpoint.hpp`.
+        void save(std::ostream & os) const {
+            os << n << ' ' << xi << ' ' << C << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> n >> xi >> C;
+            sample.load(is);
+        }
+};
+
+// Variante par mini-lots de `approx_sequence`: chaque pas tire `batch` réalisations de $\phi(X)$
+// dans un tampon contigu, évalue $H1$ et $v$ sur tout le lot, et applique la moyenne des
+// gradients obtenus. Pour un même nombre de tirages, on fait donc `batch` fois moins de pas,
+// et les boucles sur le lot, sans dépendance entre itérations, peuvent être vectorisées par le
+// compilateur.
+template<class Phi, class Gamma, class Distribution, class Generator>
+class approx_batch_sequence {
+    private:
+        double alpha, xi = 0, C = 0;
+        const Gamma & gamma;
+        int n = 0;
+
+        loss_sampler<Phi, Distribution, Generator> sample;
+        std::vector<double> losses;
+
+    public:
+        using result_type = state<2>;
+
+        // Paramètres du constructeur:
+        // * `alpha`, `phi`, `gamma`, `d`, `g`: cf `approx_sequence::approx_sequence`
+        // * `batch`: taille des mini-lots
+        approx_batch_sequence(
+            double alpha,
+            const Phi & phi,
+            const Gamma & gamma,
+            int batch,
+            Distribution & d,
+            Generator & g
+        ) :
+            alpha { alpha }, gamma { gamma }, sample { phi, d, g }, losses(batch)
+        {
+        }
+
+        // Chaque appel à `next` renvoie la valeur suivante de la suite
+        // $n \longmapsto (\xi_n, C_n)$, où chaque pas consomme un mini-lot.
+        auto next() -> result_type {
+            if (n == 0) {
+                ++n;
+                return make_state(xi, C);
+            }
+
+            auto size = losses.size();
+            sample.fill(losses.data(), size);
+
+            double H1_sum = 0, v_sum = 0;
+            for (size_t i = 0; i < size; ++i) {
+                H1_sum += H1(xi, losses[i], alpha);
+                v_sum += v(xi, losses[i], alpha);
+            }
+
+            auto step = gamma(n);
+            C -= step * (C - v_sum / size);
+            xi -= step * H1_sum / size;
+            ++n;
+            return make_state(xi, C);
+        }
+
+        // Cf `approx_sequence::save` et `approx_sequence::load`.
+        void save(std::ostream & os) const {
+            os << n << ' ' << xi << ' ' << C << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> n >> xi >> C;
+            sample.load(is);
+        }
+};
+
+// Variante de `approx_sequence` avec réduction de variance, cf `src/variance_reduction.hpp`:
+// * si `antithetic == true`, chaque pas utilise $X$ et son symétrique $X'$ (cf `reflection`),
+//   et la moyenne des deux gradients;
+// * si `Control` est une `control_variate`, on retranche aux termes $H1$ et $v$ du gradient
+//   leur projection sur $h(X) - E[h(X)]$. Les coefficients de régression sont estimés à partir
+//   des pas précédents seulement: à $\xi_n$ fixé, la correction est bien d'espérance nulle.
+template<class Phi, class Gamma, class Control, class Distribution, class Generator>
+class approx_vr_sequence {
+    private:
+        const Phi & phi;
+        double alpha, xi = 0, C = 0;
+        const Gamma & gamma;
+        Control control;
+        bool antithetic;
+        int n = 0;
+
+        // Sommes $\sum H1 \times \delta$, $\sum v \times \delta$ et $\sum \delta^2$, où $\delta$
+        // est l'écart de la variable de contrôle.
+        double xi_cov = 0, C_cov = 0, variance = 0;
+
+        const Distribution & d;
+        sampler<Distribution, Generator> sample;
+
+    public:
+        using result_type = state<2>;
+
+        // Paramètres du constructeur:
+        // * `alpha`, `phi`, `gamma`, `d`, `g`: cf `approx_sequence::approx_sequence`
+        // * `control`: variable de contrôle, ou `no_control`
+        // * `antithetic`: utiliser ou non les variables antithétiques
+        approx_vr_sequence(
+            double alpha,
+            const Phi & phi,
+            const Gamma & gamma,
+            Control control,
+            bool antithetic,
+            Distribution & d,
+            Generator & g
+        ) :
+            phi { phi }, alpha { alpha }, gamma { gamma }, control(control),
+            antithetic { antithetic }, d(d), sample { d, g }
+        {
+        }
+
+        // Chaque appel à `next` renvoie la valeur suivante de la suite
+        // $n \longmapsto (\xi_n, C_n)$.
+        auto next() -> result_type {
+            if (n == 0) {
+                ++n;
+                return make_state(xi, C);
+            }
+
+            auto x = sample();
+            auto loss = phi(x);
+            auto h1 = H1(xi, loss, alpha);
+            auto w = v(xi, loss, alpha);
+            auto delta = deviation(control, x);
+            if (antithetic) {
+                auto y = reflection<Distribution>::reflect(d, x);
+                auto reflected_loss = phi(y);
+                h1 = (h1 + H1(xi, reflected_loss, alpha)) / 2;
+                w = (w + v(xi, reflected_loss, alpha)) / 2;
+                delta = (delta + deviation(control, y)) / 2;
+            }
+
+            auto h1_corrected = h1, w_corrected = w;
+            if (variance > 0) {
+                h1_corrected -= xi_cov / variance * delta;
+                w_corrected -= C_cov / variance * delta;
+            }
+            xi_cov += h1 * delta;
+            C_cov += w * delta;
+            variance += delta * delta;
+
+            auto step = gamma(n);
+            C -= step * (C - w_corrected);
+            xi -= step * h1_corrected;
+            ++n;
+            return make_state(xi, C);
+        }
+
+        // Cf `approx_sequence::save` et `approx_sequence::load`.
+        void save(std::ostream & os) const {
+            os << n << ' ' << xi << ' ' << C << ' ' << xi_cov << ' ' << C_cov << ' '
+               << variance << '\n';
+            sample.save(os);
+        }
+
+        void load(std::istream & is) {
+            is >> n >> xi >> C >> xi_cov >> C_cov >> variance;
+            sample.load(is);
         }
 };
 
@@ -0,0 +1,95 @@
+#ifndef DETAIL_STREAM_HPP
+#define DETAIL_STREAM_HPP
+
+#include "sampler.hpp"
+#include "losses.hpp"
+#include <cstddef> // `std::size_t`
+
+namespace detail {
+
+// "Distribution" dont les réalisations sont lues dans un tableau de pertes précalculées: chaque
+// tirage renvoie `*data` puis avance d'une case. Permet d'utiliser telles quelles les suites de
+// `src/detail/stochastic_gradient.hpp` (avec $\phi$ appliquée à chaque perte lue), cf
+// `consume` plus bas.
+struct loss_cursor {
+    using result_type = double;
+
+    const double * data = nullptr;
+};
+
+// Fonction de perte des pertes déjà évaluées (cf `src/pipeline.hpp`): l'identité, mais sous
+// forme de foncteur pour que l'appel soit inliné.
+struct evaluated_loss {
+    auto operator ()(double x) const -> double {
+        return x;
+    }
+};
+
+// Générateur fictif: les pertes ne sont pas tirées.
+struct no_generator {
+};
+
+template<class Generator>
+class sampler<loss_cursor, Generator> {
+    private:
+        loss_cursor & cursor;
+
+    public:
+        using result_type = double;
+
+        sampler(loss_cursor & cursor, Generator &) : cursor(cursor)
+        {
+        }
+
+        auto operator ()() -> double {
+            return *cursor.data++;
+        }
+
+        void fill(double * out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = *cursor.data++;
+        }
+};
+
+// Pertes lues par `cursor`: toujours une à une, même si `Phi` est évaluable par blocs. Un
+// `loss_sampler` par blocs lirait `sampler_block` valeurs d'un coup, au-delà de la fin du bloc
+// courant de la source (cf `consume`).
+template<class Phi, class Generator>
+class loss_sampler<Phi, loss_cursor, Generator, true> :
+    public loss_sampler<Phi, loss_cursor, Generator, false> {
+    public:
+        using loss_sampler<Phi, loss_cursor, Generator, false>::loss_sampler;
+};
+
+// Fait avancer `sequence`, construite avec `cursor` comme distribution, d'un pas par perte lue
+// dans `source` (cf `src/stream.hpp`), bloc par bloc: la boucle sur un bloc lit directement la
+// mémoire fournie par la source. Après chaque bloc, on appelle `observer(n, state)`, `n` étant
+// le nombre de pertes lues (un `long long`: la source peut dépasser $2^{31}$ pertes, cf le
+// compteur de `approx_sequence`); on s'arrête si l'observateur renvoie `false` ou à la fin de
+// la source.
+template<class Sequence, class Source, class Observer>
+auto consume(
+    Sequence & sequence,
+    loss_cursor & cursor,
+    Source & source,
+    Observer & observer
+) -> typename Sequence::result_type
+{
+    // Terme initial $(\xi_0, C_0)$, qui ne consomme aucune perte.
+    typename Sequence::result_type state = sequence.next();
+    long long n = 0;
+    while (true) {
+        auto count = source.next_chunk(cursor.data);
+        if (count == 0)
+            break;
+        for (std::size_t i = 0; i < count; ++i)
+            state = sequence.next();
+        n += static_cast<long long>(count);
+        if (!observer(n, state))
+            break;
+    }
+    return state;
+}
+}
+
+#endif
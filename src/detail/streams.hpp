@@ -0,0 +1,69 @@
+#ifndef DETAIL_STREAMS_HPP
+#define DETAIL_STREAMS_HPP
+
+#include "../random.hpp"
+#include "../qmc.hpp"
+#include <random> // `std::seed_seq`
+#include <vector>
+#include <utility> // `std::pair`
+#include <cmath> // `std::sqrt`
+
+namespace detail {
+
+// Construit un nouveau générateur, indépendant de `g`, en l'initialisant avec une graine tirée
+// à partir de `g`. On tire plusieurs valeurs pour remplir une `std::seed_seq`, afin que
+// l'état initial du nouveau générateur ne dépende pas d'un seul entier de 32 bits.
+template<class Generator>
+auto split(Generator & g) -> Generator {
+    std::seed_seq seq { g(), g(), g(), g() };
+    return Generator { seq };
+}
+
+// Cas d'un générateur à compteur: le nouveau générateur garde la même graine et prend un numéro
+// de flux tiré à partir de `g`, ce qui garantit des suites sans recouvrement.
+inline auto split(philox4x32 & g) -> philox4x32 {
+    auto high = static_cast<std::uint64_t>(g());
+    return g.substream(high << 32 | g());
+}
+
+// Cas de la suite de Sobol: le nouveau générateur reprend la suite depuis le début, avec un
+// brouillage tiré à partir de `g`. Les réplicas sont alors des estimations quasi-Monte Carlo
+// randomisées indépendantes.
+inline auto split(qmc::sobol & g) -> qmc::sobol {
+    auto high = static_cast<std::uint64_t>(g());
+    return qmc::sobol { high << 32 | g() };
+}
+
+// Moyenne et erreur standard (écart-type empirique divisé par $\sqrt{R}$) de chacune des deux
+// composantes d'une liste de `R` estimations indépendantes.
+inline auto mean_and_error(
+    const std::vector<std::pair<double, double>> & results
+) -> std::pair<std::pair<double, double>, std::pair<double, double>>
+{
+    auto R = static_cast<double>(results.size());
+    double xi = 0, C = 0;
+    for (const auto & r : results) {
+        xi += r.first;
+        C += r.second;
+    }
+    xi /= R;
+    C /= R;
+
+    double xi_var = 0, C_var = 0;
+    for (const auto & r : results) {
+        xi_var += (r.first - xi) * (r.first - xi);
+        C_var += (r.second - C) * (r.second - C);
+    }
+    if (results.size() > 1) {
+        xi_var /= R - 1;
+        C_var /= R - 1;
+    }
+    return std::make_pair(
+        std::make_pair(xi, C),
+        std::make_pair(std::sqrt(xi_var / R), std::sqrt(C_var / R))
+    );
+}
+
+}
+
+#endif
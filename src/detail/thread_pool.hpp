@@ -0,0 +1,41 @@
+#ifndef DETAIL_THREAD_POOL_HPP
+#define DETAIL_THREAD_POOL_HPP
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm> // `std::min`, `std::max`
+
+namespace detail {
+
+// Nombre de threads à utiliser par défaut: autant que de coeurs disponibles (la norme autorise
+// `std::thread::hardware_concurrency` à renvoyer 0 si l'information n'est pas disponible).
+inline auto default_threads() -> int {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// Exécute `f(i)` pour chaque `i` dans `[0, count)` sur un groupe de `threads` threads.
+// Les tâches sont distribuées dynamiquement via un compteur atomique partagé: un thread qui a
+// fini sa tâche va chercher la suivante, ce qui équilibre la charge même si les tâches n'ont
+// pas toutes la même durée. Le thread appelant participe au calcul.
+template<class F>
+void parallel_for(int count, int threads, const F & f) {
+    threads = std::max(1, std::min(threads, count));
+    std::atomic<int> next { 0 };
+
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++)
+            f(i);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto & t : pool)
+        t.join();
+}
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef DETAIL_VARIANCE_REDUCTION_HPP
+#define DETAIL_VARIANCE_REDUCTION_HPP
+
+#include "../variance_reduction.hpp"
+#include "../qmc.hpp"
+#include <random>
+#include <cmath> // `std::log`, `std::expm1`
+
+namespace detail {
+
+// Transformation $x \longmapsto x'$ qui préserve la loi `Distribution` et renverse l'ordre, pour
+// les variables antithétiques. Cas général: pas de telle transformation connue.
+template<class Distribution>
+struct reflection {
+    static constexpr bool supported = false;
+
+    template<class Input>
+    static auto reflect(const Distribution &, const Input & x) -> Input {
+        return x;
+    }
+};
+
+// Loi normale, symétrique autour de sa moyenne: $x' = 2\mu - x$.
+template<>
+struct reflection<std::normal_distribution<>> {
+    static constexpr bool supported = true;
+
+    static auto reflect(const std::normal_distribution<> & d, double x) -> double {
+        return 2 * d.mean() - x;
+    }
+};
+
+// Loi exponentielle: si $x = F^{-1}(u)$, on prend $x' = F^{-1}(1 - u)$, c'est-à-dire
+// $x' = -\frac{1}{\lambda} \log(1 - e^{-\lambda x})$.
+template<>
+struct reflection<std::exponential_distribution<>> {
+    static constexpr bool supported = true;
+
+    static auto reflect(const std::exponential_distribution<> & d, double x) -> double {
+        return -std::log(-std::expm1(-d.lambda() * x)) / d.lambda();
+    }
+};
+
+template<>
+struct reflection<qmc::normal_distribution> : reflection<std::normal_distribution<>> {
+};
+
+template<>
+struct reflection<qmc::exponential_distribution> : reflection<std::exponential_distribution<>> {
+};
+
+// Absence de variable de contrôle.
+struct no_control {
+};
+
+// Écart $h(x) - E[h(X)]$ de la variable de contrôle; toujours nul en l'absence de variable
+// de contrôle, ce qui désactive la correction.
+template<class Input>
+auto deviation(const no_control &, const Input &) -> double {
+    return 0;
+}
+
+template<class H>
+auto deviation(const control_variate<H> & control, double x) -> double {
+    return control.h(x) - control.mean;
+}
+
+}
+
+#endif
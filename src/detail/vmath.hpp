@@ -0,0 +1,124 @@
+#ifndef DETAIL_VMATH_HPP
+#define DETAIL_VMATH_HPP
+
+#include <cstdint>
+#include <cstring> // `std::memcpy`
+
+// Fonctions mathématiques écrites sans branchement ni appel à la bibliothèque C, pour que le
+// compilateur puisse vectoriser les boucles qui les appellent (ce qu'il ne peut pas faire
+// avec `std::log` ou `std::cos`). La précision obtenue est de l'ordre de quelques ulp, ce qui
+// est largement suffisant pour générer des variables aléatoires ou évaluer des pertes.
+namespace detail {
+
+inline auto as_double(std::uint64_t i) -> double {
+    double d;
+    std::memcpy(&d, &i, sizeof d);
+    return d;
+}
+
+inline auto as_bits(double d) -> std::uint64_t {
+    std::uint64_t i;
+    std::memcpy(&i, &d, sizeof i);
+    return i;
+}
+
+// Logarithme népérien, pour `x` strictement positif, fini et normalisé.
+// On écrit $x = m 2^e$ avec $m \in [\sqrt{2}/2, \sqrt{2}[$, puis
+// $\log(m) = 2 \operatorname{atanh}(s)$ avec $s = \frac{m - 1}{m + 1}$, $|s| < 0.172$.
+inline auto fast_log(double x) -> double {
+    auto bits = as_bits(x);
+    // Exposant converti en flottant sans passer par une conversion entière, qui n'est pas
+    // vectorisable sur toutes les architectures.
+    auto e = as_double(0x4330000000000000ULL | (bits >> 52)) - 4503599627370496.0 - 1023;
+    auto m = as_double((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    auto big = m > 1.4142135623730951;
+    m = big ? 0.5 * m : m;
+    e = big ? e + 1 : e;
+
+    auto s = (m - 1) / (m + 1);
+    auto s2 = s * s;
+    auto p = 1. / 21;
+    p = p * s2 + 1. / 19;
+    p = p * s2 + 1. / 17;
+    p = p * s2 + 1. / 15;
+    p = p * s2 + 1. / 13;
+    p = p * s2 + 1. / 11;
+    p = p * s2 + 1. / 9;
+    p = p * s2 + 1. / 7;
+    p = p * s2 + 1. / 5;
+    p = p * s2 + 1. / 3;
+    p = p * s2 + 1;
+    return e * 0.6931471805599453 + 2 * s * p;
+}
+
+// Exponentielle, pour `x` dans $[-708, 709]$ (les valeurs en dehors sont ramenées aux bornes).
+// On écrit $x = k \log 2 + r$ avec $k$ entier et $|r| \leq \frac{\log 2}{2}$, puis
+// $e^x = 2^k e^r$, $e^r$ étant donné par son développement de Taylor à l'ordre 12 et $2^k$
+// construit directement dans l'exposant.
+inline auto fast_exp(double x) -> double {
+    x = x < -708. ? -708. : x;
+    x = x > 709. ? 709. : x;
+
+    // Même arrondi que dans `sincos_2pi`: les bits de poids faible de `shifted` contiennent $k$.
+    auto shifted = x * 1.4426950408889634 + 6755399441055744.0;
+    auto k = shifted - 6755399441055744.0;
+    auto r = (x - k * 0.6931471803691238) - k * 1.9082149292705877e-10;
+
+    auto p = 1. / 479001600;
+    p = p * r + 1. / 39916800;
+    p = p * r + 1. / 3628800;
+    p = p * r + 1. / 362880;
+    p = p * r + 1. / 40320;
+    p = p * r + 1. / 5040;
+    p = p * r + 1. / 720;
+    p = p * r + 1. / 120;
+    p = p * r + 1. / 24;
+    p = p * r + 1. / 6;
+    p = p * r + 0.5;
+    p = p * r + 1;
+    p = p * r + 1;
+    return p * as_double((as_bits(shifted) + 1023) << 52);
+}
+
+// Calcule $\sin(2 \pi u)$ et $\cos(2 \pi u)$ pour `u` dans $[0, 1[$. On se ramène à un angle
+// $r \in [-\pi/4, \pi/4]$ et à un quadrant, puis on évalue les développements de Taylor de
+// $\sin$ et $\cos$ en $r$.
+inline void sincos_2pi(double u, double & s, double & c) {
+    // Arrondi de `q` à l'entier le plus proche par ajout de $1.5 \times 2^{52}$: après
+    // l'addition, les bits de poids faible de la mantisse contiennent cet entier.
+    auto q = 4 * u;
+    auto shifted = q + 6755399441055744.0;
+    auto k = as_bits(shifted);
+    auto r = (q - (shifted - 6755399441055744.0)) * 1.5707963267948966;
+    auto r2 = r * r;
+
+    auto sin_r = 1 - r2 / 272;
+    sin_r = 1 - r2 / 210 * sin_r;
+    sin_r = 1 - r2 / 156 * sin_r;
+    sin_r = 1 - r2 / 110 * sin_r;
+    sin_r = 1 - r2 / 72 * sin_r;
+    sin_r = 1 - r2 / 42 * sin_r;
+    sin_r = 1 - r2 / 20 * sin_r;
+    sin_r = 1 - r2 / 6 * sin_r;
+    sin_r *= r;
+
+    auto cos_r = 1 - r2 / 240;
+    cos_r = 1 - r2 / 182 * cos_r;
+    cos_r = 1 - r2 / 132 * cos_r;
+    cos_r = 1 - r2 / 90 * cos_r;
+    cos_r = 1 - r2 / 56 * cos_r;
+    cos_r = 1 - r2 / 30 * cos_r;
+    cos_r = 1 - r2 / 12 * cos_r;
+    cos_r = 1 - r2 / 2 * cos_r;
+
+    // Rotation d'un quart de tour par quadrant.
+    auto swap = (k & 1) != 0;
+    auto ss = swap ? cos_r : sin_r;
+    auto cc = swap ? sin_r : cos_r;
+    s = (k & 2) != 0 ? -ss : ss;
+    c = ((k + 1) & 2) != 0 ? -cc : cc;
+}
+
+}
+
+#endif
@@ -3,44 +3,153 @@
 
 #include "detail/stochastic_gradient.hpp"
 #include "detail/importance_sampling.hpp"
+#include "detail/multi_level.hpp"
+#include "detail/portfolios.hpp"
 #include "detail/iterate.hpp"
 #include "detail/averaging.hpp"
+#include "detail/checkpoint.hpp"
+#include "detail/variance_reduction.hpp"
+#include "detail/stream.hpp"
+#include "detail/empirical.hpp"
 #include "steps.hpp"
 #include "averaging.hpp"
+#include "parallel.hpp"
+#include "checkpoint.hpp"
+#include "qmc.hpp"
+#include "variance_reduction.hpp"
+#include "stream.hpp"
+#include "pipeline.hpp"
+#include "metrics.hpp"
+#include "switching.hpp"
+#include "losses.hpp"
+#include <vector>
+#include <string>
+#include <type_traits> // `std::is_same`
+#include <sstream>
+#include <limits> // `std::numeric_limits`
+#include <algorithm> // `std::max`
+#include <utility> // `std::pair`, `std::move`
 
 // Calcul de la V@R et de la CV@R qui suit l'approche par gradient stochastique présentée en
 // section 2.2. Pour simplifier, on n'offre pas la possibilité de calculer la $\Psi$-CVaR,
 // ou bien pour résumer on fixe $\Psi = Id$.
 // En pratique, ne converge bien que pour un niveau de confiance proche de 1/2.
-template<class Phi, class Gamma>
+// Le paramètre `Control` est le type de la variable de contrôle éventuelle, cf
+// `src/variance_reduction.hpp`.
+template<class Phi, class Gamma, class Control = detail::no_control>
 class approx_kernel {
     private:
         const Phi & phi;
         const Gamma & gamma;
         double alpha;
         averaging avg;
-        int iterations;
+        int iterations, batch;
+        antithetic anti;
+        Control control;
+
+        auto reduces_variance() const -> bool {
+            return anti == antithetic::yes || !std::is_same<Control, detail::no_control>::value;
+        }
+
+        // Nombre de pas de la suite avec réduction de variance: un pas antithétique coûte deux
+        // évaluations de $\phi$.
+        template<class Distribution>
+        auto variance_reduction_steps() const -> int {
+            if (batch > 1)
+                throw std::string { "variance reduction is not available with mini-batches" };
+            if (anti == antithetic::no)
+                return iterations;
+            if (!detail::reflection<Distribution>::supported)
+                throw std::string { "antithetic variates are not available for this distribution" };
+            return iterations / 2;
+        }
+
+        template<class Sequence, class Observer>
+        auto run(Sequence seq, int steps, Observer & observer) -> std::pair<double, double> {
+            detail::state<2> result {};
+            if (avg == averaging::no) {
+                result = detail::iterate(seq, steps, observer);
+            } else {
+                auto avg_seq = detail::averaging<decltype(seq)> { std::move(seq) };
+                result = detail::iterate(avg_seq, steps, observer);
+            }
+            return std::make_pair(result[0], result[1]);
+        }
+
+        // Idem, avec sauvegardes et reprise, cf `src/detail/checkpoint.hpp`.
+        template<class Sequence, class Observer, class Checkpointed>
+        auto run(
+            Sequence seq,
+            int steps,
+            Observer & observer,
+            Checkpointed & checkpointed
+        ) -> std::pair<double, double> {
+            detail::state<2> result {};
+            if (avg == averaging::no) {
+                result = checkpointed.iterate(seq, 0, steps, observer);
+            } else {
+                auto avg_seq = detail::averaging<decltype(seq)> { std::move(seq) };
+                result = checkpointed.iterate(avg_seq, 0, steps, observer);
+            }
+            return std::make_pair(result[0], result[1]);
+        }
+
+        // Description du noyau écrite dans les sauvegardes: on ne peut reprendre une sauvegarde
+        // qu'avec les mêmes paramètres (hormis le nombre d'itérations), suite de pas comprise.
+        auto description() const -> std::string {
+            std::ostringstream os;
+            os.precision(std::numeric_limits<double>::max_digits10);
+            os << "stochastic-gradient alpha=" << alpha << " batch=" << batch << " averaging="
+               << (avg == averaging::yes ? "yes" : "no") << " antithetic="
+               << (anti == antithetic::yes ? "yes" : "no") << " control="
+               << (std::is_same<Control, detail::no_control>::value ? "no" : "yes") << " "
+               << detail::describe_steps(gamma);
+            return os.str();
+        }
 
     public:
         // Paramètres du constructeur:
         // * `alpha`: niveau de confiance
         // * `phi`: foncteur `* -> double` représentant la fonction de perte $\phi$
-        // * `gamma`: foncteur `int -> double`, `gamma(n)` représentant la suite $\gamma_n$
-        //            de l'article
+        // * `gamma`: foncteur `long long -> double`, `gamma(n)` représentant la suite
+        //            $\gamma_n$ de l'article
         // * `avg`: appliquer ou non la moyennisation de Ruppert et Polyak (théorème 2.3)
-        // * `iterations`: nombre d'itérations de l'algorithme
+        // * `iterations`: nombre d'itérations de l'algorithme, c'est-à-dire de tirages de $X$
+        // * `batch`: taille des mini-lots, cf `src/detail/stochastic_gradient.hpp`; si
+        //            `batch > 1`, on ne fait plus que `iterations / batch` pas
+        // * `anti`, `control`: réduction de variance, cf `src/variance_reduction.hpp`
+        //                      (incompatible avec `batch > 1`); `iterations` compte alors
+        //                      les évaluations de $\phi$
         approx_kernel(
             double alpha,
             const Phi & phi,
             const Gamma & gamma,
             averaging avg,
-            int iterations
+            int iterations,
+            int batch = 1,
+            antithetic anti = antithetic::no,
+            Control control = Control { }
         ) :
             alpha { alpha }, phi { phi }, gamma { gamma }, avg { avg },
-            iterations { iterations }
+            iterations { iterations }, batch { batch }, anti { anti }, control(control)
         {
         }
 
+        // Renvoie une copie du noyau dont le nombre d'itérations est divisé par `replicas`,
+        // cf `src/parallel.hpp`.
+        auto per_replica(int replicas) const -> approx_kernel {
+            return approx_kernel {
+                alpha,
+                phi,
+                gamma,
+                avg,
+                iterations / replicas,
+                batch,
+                anti,
+                control
+            };
+        }
+
         // Paramètres génériques d'un noyau de calcul:
         // * `d`: foncteur `Generator -> *` représentant la distribution de $X$,
         //        usuellement on prend un objet défini dans le header <random>
@@ -48,6 +157,101 @@ class approx_kernel {
         //        défini dans le header <random>
         template<class Distribution, class Generator>
         auto compute(Distribution & d, Generator & g) -> std::pair<double, double> {
+            detail::no_observer observer;
+            return compute(d, g, observer);
+        }
+
+        // Idem, mais chaque terme $(\xi_n, C_n)$ calculé est passé à `observer`, qui peut
+        // demander un arrêt anticipé, cf `src/detail/iterate.hpp` et `src/stopping.hpp`.
+        // Avec des mini-lots, `n` compte les pas et non les tirages.
+        template<class Distribution, class Generator, class Observer>
+        auto compute(
+            Distribution & d,
+            Generator & g,
+            Observer & observer
+        ) -> std::pair<double, double> {
+            if (reduces_variance()) {
+                auto steps = variance_reduction_steps<Distribution>();
+                using sequence =
+                    detail::approx_vr_sequence<Phi, Gamma, Control, Distribution, Generator>;
+                auto seq = sequence {
+                    alpha,
+                    phi,
+                    gamma,
+                    control,
+                    anti == antithetic::yes,
+                    d,
+                    g
+                };
+                return run(std::move(seq), steps, observer);
+            }
+
+            if (batch > 1) {
+                auto seq = detail::approx_batch_sequence<Phi, Gamma, Distribution, Generator> {
+                    alpha,
+                    phi,
+                    gamma,
+                    batch,
+                    d,
+                    g
+                };
+                return run(std::move(seq), iterations / batch, observer);
+            }
+
+            auto seq = detail::approx_sequence<Phi, Gamma, Distribution, Generator> {
+                alpha,
+                phi,
+                gamma,
+                d,
+                g
+            };
+            return run(std::move(seq), iterations, observer);
+        }
+
+        // Idem, en écrivant des sauvegardes et en reprenant éventuellement depuis l'une d'elles
+        // selon `cp`, cf `src/checkpoint.hpp`.
+        template<class Distribution, class Generator, class Observer>
+        auto compute(
+            Distribution & d,
+            Generator & g,
+            Observer & observer,
+            const checkpoint & cp
+        ) -> std::pair<double, double> {
+            auto checkpointed = detail::checkpointed<Distribution, Generator> {
+                cp,
+                description(),
+                d,
+                g
+            };
+
+            if (reduces_variance()) {
+                auto steps = variance_reduction_steps<Distribution>();
+                using sequence =
+                    detail::approx_vr_sequence<Phi, Gamma, Control, Distribution, Generator>;
+                auto seq = sequence {
+                    alpha,
+                    phi,
+                    gamma,
+                    control,
+                    anti == antithetic::yes,
+                    d,
+                    g
+                };
+                return run(std::move(seq), steps, observer, checkpointed);
+            }
+
+            if (batch > 1) {
+                auto seq = detail::approx_batch_sequence<Phi, Gamma, Distribution, Generator> {
+                    alpha,
+                    phi,
+                    gamma,
+                    batch,
+                    d,
+                    g
+                };
+                return run(std::move(seq), iterations / batch, observer, checkpointed);
+            }
+
             auto seq = detail::approx_sequence<Phi, Gamma, Distribution, Generator> {
                 alpha,
                 phi,
@@ -55,15 +259,81 @@ class approx_kernel {
                 d,
                 g
             };
+            return run(std::move(seq), iterations, observer, checkpointed);
+        }
 
-            std::tuple<double, double> result;
+        // Variante de `compute` où les réalisations de $X$ ne sont pas tirées mais lues dans
+        // `source` (cf `src/stream.hpp`), par exemple des pertes calculées par un autre
+        // programme (on prend alors `phi = identity`): on fait un pas par perte lue, jusqu'à la
+        // fin de la source, et `iterations` est ignoré. L'observateur n'est appelé qu'après
+        // chaque bloc de la source, avec le nombre de pertes déjà lues, cf
+        // `src/detail/stream.hpp`. Incompatible avec les mini-lots et la réduction de variance.
+        template<class Source, class Observer>
+        auto consume(Source & source, Observer & observer) -> std::pair<double, double> {
+            return consume_losses(phi, source, observer);
+        }
+
+        // Variante de `compute` en pipeline, cf `src/pipeline.hpp`: `producers` threads tirent
+        // $X$ et évaluent $\phi(X)$ à l'avance, par blocs, pendant que le thread appelant fait
+        // avancer la suite. Avec un seul producteur, le résultat est exactement celui de
+        // `compute`. L'observateur n'est appelé qu'après chaque bloc, cf `consume`.
+        // Incompatible avec les mini-lots et la réduction de variance.
+        template<class Distribution, class Generator, class Observer>
+        auto pipelined_compute(
+            Distribution & d,
+            Generator & g,
+            int producers,
+            Observer & observer
+        ) -> std::pair<double, double> {
+            if (batch > 1 || reduces_variance())
+                throw std::string {
+                    "mini-batches and variance reduction are not available with a pipeline"
+                };
+            // La suite fait `iterations - 1` pas après le terme initial, cf `compute`.
+            auto samples = static_cast<std::size_t>(std::max(iterations - 1, 0));
+            pipelined_losses<Phi, Distribution, Generator> source {
+                phi,
+                d,
+                g,
+                samples,
+                producers
+            };
+            detail::evaluated_loss loss;
+            return consume_losses(loss, source, observer);
+        }
+
+        template<class Distribution, class Generator>
+        auto pipelined_compute(
+            Distribution & d,
+            Generator & g,
+            int producers
+        ) -> std::pair<double, double> {
+            detail::no_observer observer;
+            return pipelined_compute(d, g, producers, observer);
+        }
+
+    private:
+        // Cf `consume`, avec la fonction de perte `loss` appliquée à chaque perte lue.
+        template<class Loss, class Source, class Observer>
+        auto consume_losses(
+            const Loss & loss,
+            Source & source,
+            Observer & observer
+        ) -> std::pair<double, double> {
+            detail::loss_cursor cursor;
+            detail::no_generator g;
+            using sequence =
+                detail::approx_sequence<Loss, Gamma, detail::loss_cursor, detail::no_generator>;
+            auto seq = sequence { alpha, loss, gamma, cursor, g };
+
+            detail::state<2> result {};
             if (avg == averaging::no) {
-                result = detail::iterate(seq, iterations);
+                result = detail::consume(seq, cursor, source, observer);
             } else {
-                auto avg_seq = detail::averaging<decltype(seq)> { std::move(seq) };
-                result = detail::iterate(avg_seq, iterations);
+                auto avg_seq = detail::averaging<sequence> { std::move(seq) };
+                result = detail::consume(avg_seq, cursor, source, observer);
             }
-            return std::make_pair(std::get<0>(result), std::get<1>(result));
+            return std::make_pair(result[0], result[1]);
         }
 };
 
@@ -76,29 +346,85 @@ class IS_kernel {
         double alpha, a;
         averaging avg;
         int iterations;
+        switching sw;
+        IS_metrics * metrics = nullptr;
+
+        // Avec `switching::adaptive`, nombre maximal de pas de la phase 1 et taille des
+        // fenêtres de `detail::phase1_monitor`.
+        auto monitor() const -> detail::phase1_monitor {
+            return detail::phase1_monitor {
+                alpha,
+                iterations / 10,
+                std::max(iterations / 10000, 100)
+            };
+        }
+
+        // Cf `approx_kernel::description`.
+        auto description() const -> std::string {
+            std::ostringstream os;
+            os.precision(std::numeric_limits<double>::max_digits10);
+            os << "importance-sampling alpha=" << alpha << " a=" << a << " averaging="
+               << (avg == averaging::yes ? "yes" : "no") << " switching="
+               << (sw == switching::adaptive ? "adaptive" : "fixed") << " "
+               << detail::describe_steps(gamma);
+            return os.str();
+        }
     
     public:
         // Paramètres du constructeur:
         // * `alpha`, `phi`, `gamma`, `avg`, `gamma`: cf `approx_kernel::approx_kernel`
         // * `a`: paramètre du contrôle exponentiel sur $x \longmapsto \phi^2(x)$
+        // * `sw`: durée de la phase 1, cf `src/switching.hpp`; avec `switching::fixed`, on fait
+        //   `iterations / 100` pas de phase 1 puis `iterations` pas de phase 2, et avec
+        //   `switching::adaptive`, au plus `iterations / 10` pas de phase 1, la phase 2
+        //   complétant le même budget total de `iterations + iterations / 100` pas
         IS_kernel(
             double alpha,
             double a,
             const Phi & phi,
             const Gamma & gamma,
             averaging avg,
-            int iterations
+            int iterations,
+            switching sw = switching::fixed
         ) :
             alpha { alpha }, a { a }, phi { phi }, gamma { gamma }, avg { avg },
-            iterations { iterations }
+            iterations { iterations }, sw { sw }
         {
         }
 
+        // Cf `approx_kernel::per_replica`. Les copies ne gardent pas les mesures de `measure`.
+        auto per_replica(int replicas) const -> IS_kernel {
+            return IS_kernel { alpha, a, phi, gamma, avg, iterations / replicas, sw };
+        }
+
+        // Renseigne `m` (cf `src/metrics.hpp`) lors des appels à `compute` sans sauvegardes;
+        // `m` doit exister jusqu'à la fin de ces calculs. Sans effet sur les résultats.
+        auto measure(IS_metrics & m) -> IS_kernel & {
+            metrics = &m;
+            return *this;
+        }
+
         // Paramètres génériques d'un noyau de calcul: cf `approx_kernel::compute`.
         template<class Distribution, class Generator>
         auto compute(Distribution & d, Generator & g) -> std::pair<double, double> {
-            // On fixe le nombre d'itérations pour la première phase à `iterations / 100`.
+            detail::no_observer observer;
+            return compute(d, g, observer);
+        }
+
+        // Cf `approx_kernel::compute`; l'observateur voit d'abord les termes
+        // $(\xi_n, \theta_n, \mu_n)$ de la phase 1, puis les termes $(\xi_n, C_n)$ de la
+        // phase 2 (`n` repartant de 0).
+        template<class Distribution, class Generator, class Observer>
+        auto compute(
+            Distribution & d,
+            Generator & g,
+            Observer & observer
+        ) -> std::pair<double, double> {
+            // On fixe le nombre d'itérations pour la première phase à `iterations / 100`, ou
+            // bien on la surveille pour passer à la phase 2 dès qu'elle a convergé.
             auto M = iterations / 100;
+            auto steps = iterations;
+            auto watch = monitor();
             auto phase1 = detail::IS_phase1_sequence<Phi, Gamma, Distribution, Generator> {
                 alpha,
                 a,
@@ -106,31 +432,350 @@ class IS_kernel {
                 gamma,
                 M,
                 d,
-                g
+                g,
+                sw == switching::adaptive ? &watch : nullptr,
+                metrics
             };
 
-            auto phase1_result = detail::iterate(phase1, M);
+            if (metrics != nullptr)
+                metrics->begin(0);
+            auto phase1_result = decltype(phase1.next()) { };
+            if (sw == switching::fixed) {
+                phase1_result = detail::iterate(phase1, M, observer);
+            } else {
+                auto watched = detail::phase1_observer<Observer> { observer, watch };
+                phase1_result = detail::iterate(phase1, iterations / 10 + 1, watched);
+                steps = iterations + M - watch.iterations();
+            }
+            if (metrics != nullptr)
+                metrics->end(0);
 
             // On réinjecte les paramètres estimés dans la première phase pour la deuxième phase.
             auto phase2 = detail::IS_phase2_sequence<Phi, Gamma, Distribution, Generator> {
                 alpha,
-                std::get<0>(phase1_result),
-                std::get<1>(phase1_result),
-                std::get<2>(phase1_result),
+                phase1_result[0],
+                detail::phase1_theta(phase1_result),
+                detail::phase1_mu(phase1_result),
                 phi,
                 gamma,
                 d,
+                g,
+                metrics
+            };
+
+            if (metrics != nullptr)
+                metrics->begin(1);
+            detail::state<2> result {};
+            if (avg == averaging::no) {
+                result = detail::iterate(phase2, steps, observer);
+            } else {
+                auto avg_seq = detail::averaging<decltype(phase2)> { std::move(phase2) };
+                result = detail::iterate(avg_seq, steps, observer);
+            }
+            if (metrics != nullptr)
+                metrics->end(1);
+            return std::make_pair(result[0], result[1]);
+        }
+
+        // Cf `approx_kernel::compute`. Une sauvegarde de la phase 2 permet de reprendre
+        // directement la phase 2, sans refaire la phase 1. L'état de `switching::adaptive`
+        // n'étant pas sauvegardé, on ne peut s'en servir ici.
+        template<class Distribution, class Generator, class Observer>
+        auto compute(
+            Distribution & d,
+            Generator & g,
+            Observer & observer,
+            const checkpoint & cp
+        ) -> std::pair<double, double> {
+            if (sw == switching::adaptive)
+                throw std::string { "adaptive switching is not available with checkpoints" };
+            auto checkpointed = detail::checkpointed<Distribution, Generator> {
+                cp,
+                description(),
+                d,
                 g
             };
 
-            std::tuple<double, double> result;
+            auto M = iterations / 100;
+            auto phase1 = detail::IS_phase1_sequence<Phi, Gamma, Distribution, Generator> {
+                alpha,
+                a,
+                phi,
+                gamma,
+                M,
+                d,
+                g
+            };
+
+            // Si l'on reprend la phase 2, les paramètres passés ici sont remplacés par ceux de
+            // la sauvegarde.
+            auto phase1_result = decltype(phase1.next()) { };
+            if (checkpointed.resumed_phase() != 1)
+                phase1_result = checkpointed.iterate(phase1, 0, M, observer);
+
+            auto phase2 = detail::IS_phase2_sequence<Phi, Gamma, Distribution, Generator> {
+                alpha,
+                phase1_result[0],
+                detail::phase1_theta(phase1_result),
+                detail::phase1_mu(phase1_result),
+                phi,
+                gamma,
+                d,
+                g
+            };
+
+            detail::state<2> result {};
             if (avg == averaging::no) {
-                result = detail::iterate(phase2, iterations);
+                result = checkpointed.iterate(phase2, 1, iterations, observer);
             } else {
                 auto avg_seq = detail::averaging<decltype(phase2)> { std::move(phase2) };
-                result = detail::iterate(avg_seq, iterations);
+                result = checkpointed.iterate(avg_seq, 1, iterations, observer);
             }
-            return std::make_pair(std::get<0>(result), std::get<1>(result));
+            return std::make_pair(result[0], result[1]);
+        }
+
+        // Variante parallèle de `compute`, sur `chains` suites exécutées par `threads` threads,
+        // chacune avec sa propre copie de `d` et son propre générateur (tirés à partir de `g`
+        // avant de lancer les threads, cf `replicated_kernel::compute`: le résultat ne dépend
+        // pas du nombre de threads).
+        // * Phase 1: chaque suite fait les `iterations / 100` itérations de `compute`, et l'on
+        //   prend la moyenne des $(\xi, \theta, \mu)$ obtenus.
+        // * Phase 2: chaque suite repart de ces valeurs moyennes, fait `iterations / chains`
+        //   itérations avec les pas `steps::scaled { gamma, chains }`, et l'on prend la moyenne
+        //   des $(\xi, C)$ obtenus: le résultat ne dépend pas de `chains`, au bruit près.
+        // La phase 2 garde le budget d'itérations de `compute`, et sa durée est à peu près
+        // divisée par `min(chains, threads)`. Seul `switching::fixed` est possible.
+        template<class Distribution, class Generator>
+        auto parallel_compute(
+            Distribution & d,
+            Generator & g,
+            int chains,
+            int threads = detail::default_threads()
+        ) -> std::pair<double, double> {
+            using phase1_sequence = detail::IS_phase1_sequence<Phi, Gamma, Distribution, Generator>;
+            if (sw == switching::adaptive)
+                throw std::string { "adaptive switching is not available with parallel chains" };
+
+            std::vector<Generator> generators;
+            std::vector<Distribution> distributions;
+            for (int c = 0; c < chains; ++c) {
+                generators.push_back(detail::split(g));
+                distributions.push_back(d);
+                distributions.back().reset();
+            }
+
+            auto M = iterations / 100;
+            std::vector<typename phase1_sequence::result_type> phase1_results(chains);
+            detail::parallel_for(chains, threads, [&](int c) {
+                auto phase1 = phase1_sequence {
+                    alpha,
+                    a,
+                    phi,
+                    gamma,
+                    M,
+                    distributions[c],
+                    generators[c]
+                };
+                phase1_results[c] = detail::iterate(phase1, M);
+            });
+
+            auto phase1_result = phase1_results[0];
+            for (int c = 1; c < chains; ++c)
+                phase1_result += phase1_results[c];
+            phase1_result /= chains;
+
+            // Chaque suite ne fait que `iterations / chains` pas: avec les pas de `gamma`, elle
+            // garderait davantage de sa phase transitoire qu'une suite unique de `iterations`
+            // pas, et le biais croîtrait avec `chains`. On lui donne donc les pas accélérés de
+            // `steps::scaled`.
+            auto steps = iterations / chains;
+            auto scaled_gamma = steps::scaled<Gamma> { gamma, chains };
+            using phase2_sequence = detail::IS_phase2_sequence<Phi, steps::scaled<Gamma>, Distribution, Generator>;
+            std::vector<detail::state<2>> phase2_results(chains);
+            detail::parallel_for(chains, threads, [&](int c) {
+                auto phase2 = phase2_sequence {
+                    alpha,
+                    phase1_result[0],
+                    detail::phase1_theta(phase1_result),
+                    detail::phase1_mu(phase1_result),
+                    phi,
+                    scaled_gamma,
+                    distributions[c],
+                    generators[c]
+                };
+                if (avg == averaging::no) {
+                    phase2_results[c] = detail::iterate(phase2, steps);
+                } else {
+                    auto avg_seq = detail::averaging<phase2_sequence> { std::move(phase2) };
+                    phase2_results[c] = detail::iterate(avg_seq, steps);
+                }
+            });
+
+            auto result = detail::state<2> { };
+            for (const auto & r : phase2_results)
+                result += r;
+            result /= chains;
+            return std::make_pair(result[0], result[1]);
+        }
+};
+
+// Calcul simultané de la V@R et de la CV@R pour plusieurs niveaux de confiance, avec
+// l'algorithme de `approx_kernel`: chaque tirage de $X$ et chaque évaluation de $\phi(X)$ sert
+// à tous les niveaux.
+template<class Phi, class Gamma>
+class levels_kernel {
+    private:
+        const Phi & phi;
+        const Gamma & gamma;
+        std::vector<double> alphas;
+        averaging avg;
+        int iterations;
+
+    public:
+        // Paramètres du constructeur:
+        // * `alphas`: niveaux de confiance
+        // * `phi`, `gamma`, `avg`, `iterations`: cf `approx_kernel::approx_kernel`
+        levels_kernel(
+            std::vector<double> alphas,
+            const Phi & phi,
+            const Gamma & gamma,
+            averaging avg,
+            int iterations
+        ) :
+            phi { phi }, gamma { gamma }, alphas { std::move(alphas) }, avg { avg },
+            iterations { iterations }
+        {
+        }
+
+        // Paramètres génériques d'un noyau de calcul: cf `approx_kernel::compute`.
+        // Renvoie un couple $(\xi, C)$ par niveau, dans l'ordre de `alphas`.
+        template<class Distribution, class Generator>
+        auto compute(Distribution & d, Generator & g) -> std::vector<std::pair<double, double>> {
+            auto seq = detail::levels_sequence<Phi, Gamma, Distribution, Generator> {
+                alphas,
+                phi,
+                gamma,
+                avg == averaging::yes,
+                d,
+                g
+            };
+
+            // On n'utilise pas `detail::iterate`, qui copierait l'état à chaque itération.
+            for (int n = 0; n < iterations - 1; ++n)
+                seq.next();
+            const auto & state = seq.next();
+
+            std::vector<std::pair<double, double>> result;
+            for (std::size_t k = 0; k < alphas.size(); ++k)
+                result.emplace_back(state.xi[k], state.C[k]);
+            return result;
+        }
+};
+
+// Calcul simultané de la V@R et de la CV@R de plusieurs portefeuilles, décrits par leurs
+// fonctions de perte $\phi_p$ et exposés aux mêmes facteurs de risque $X$, avec l'algorithme de
+// `approx_kernel`: chaque tirage de $X$ sert à tous les portefeuilles. Le résultat de chaque
+// portefeuille est celui que donnerait `approx_kernel` avec le même générateur.
+template<class Phi, class Gamma>
+class portfolios_kernel {
+    private:
+        double alpha;
+        const std::vector<Phi> & phis;
+        const Gamma & gamma;
+        averaging avg;
+        int iterations;
+
+    public:
+        // Paramètres du constructeur:
+        // * `phis`: fonctions de perte des portefeuilles
+        // * `alpha`, `gamma`, `avg`, `iterations`: cf `approx_kernel::approx_kernel`
+        portfolios_kernel(
+            double alpha,
+            const std::vector<Phi> & phis,
+            const Gamma & gamma,
+            averaging avg,
+            int iterations
+        ) :
+            alpha { alpha }, phis(phis), gamma { gamma }, avg { avg }, iterations { iterations }
+        {
+        }
+
+        // Paramètres génériques d'un noyau de calcul: cf `approx_kernel::compute`.
+        // Renvoie un couple $(\xi, C)$ par portefeuille, dans l'ordre de `phis`.
+        template<class Distribution, class Generator>
+        auto compute(Distribution & d, Generator & g) -> std::vector<std::pair<double, double>> {
+            auto seq = detail::portfolios_sequence<Phi, Gamma, Distribution, Generator> {
+                alpha,
+                phis,
+                gamma,
+                avg == averaging::yes,
+                d,
+                g
+            };
+
+            // Cf `levels_kernel::compute`.
+            for (int n = 0; n < iterations - 1; ++n)
+                seq.next();
+            const auto & state = seq.next();
+
+            std::vector<std::pair<double, double>> result;
+            for (std::size_t p = 0; p < phis.size(); ++p)
+                result.emplace_back(state.xi[p], state.C[p]);
+            return result;
+        }
+};
+
+// Valeurs de référence de la V@R et de la CV@R: on tire `samples` pertes $\phi(X_i)$ et l'on
+// calcule exactement la V@R et la CV@R de leur loi empirique, soit la
+// $\lceil \alpha N \rceil$-ième plus petite perte $\xi$ et
+// $C = \xi + \frac{1}{(1 - \alpha) N} \sum_i (\phi(X_i) - \xi)^+$. Sert à valider les
+// estimations des autres noyaux lorsqu'on ne connaît pas de valeur exacte.
+// Le calcul ne trie pas les pertes, et se fait en plusieurs passes parallèles par tranches, cf
+// `src/detail/empirical.hpp/empirical_var_cvar`. Si les pertes tiennent dans `memory`
+// flottants, elles sont tirées une seule fois; sinon, elles sont tirées à nouveau à chaque
+// passe (en général trois), à mémoire constante.
+template<class Phi>
+class empirical_kernel {
+    private:
+        const Phi & phi;
+        double alpha;
+        long long samples;
+        int threads;
+        std::size_t memory;
+
+    public:
+        // Paramètres du constructeur:
+        // * `alpha`: niveau de confiance
+        // * `phi`: cf `approx_kernel::approx_kernel`
+        // * `samples`: nombre de pertes tirées, au moins 1
+        // * `threads`: nombre de threads à utiliser
+        // * `memory`: nombre maximal de pertes gardées en mémoire
+        empirical_kernel(
+            double alpha,
+            const Phi & phi,
+            long long samples,
+            int threads,
+            std::size_t memory
+        ) : phi(phi), alpha { alpha }, samples { samples }, threads { threads }, memory { memory }
+        {
+            if (samples <= 0)
+                throw std::string { "the empirical estimate needs at least one sample" };
+        }
+
+        // Paramètres génériques d'un noyau de calcul: cf `approx_kernel::compute`. Chaque
+        // tranche de pertes a son propre générateur, tiré de `g`: le résultat ne dépend pas
+        // du nombre de threads, ni de `memory`.
+        template<class Distribution, class Generator>
+        auto compute(Distribution & d, Generator & g) -> std::pair<double, double> {
+            auto chunks = detail::loss_chunks<Phi, Distribution, Generator> {
+                phi,
+                d,
+                g,
+                samples,
+                threads,
+                memory
+            };
+            return detail::empirical_var_cvar(chunks, alpha);
         }
 };
 
@@ -150,10 +795,36 @@ auto stochastic_gradient(
     int iterations,
     const Phi & phi = identity,
     const Gamma & gamma = steps::inverse, // par défaut, on prend $\gamma_n = \frac{1}{n}$
-    averaging avg = averaging::no
+    averaging avg = averaging::no,
+    int batch = 1,
+    antithetic anti = antithetic::no
 ) -> approx_kernel<Phi, Gamma>
 {
-    return approx_kernel<Phi, Gamma> { alpha, phi, gamma, avg, iterations };
+    return approx_kernel<Phi, Gamma> { alpha, phi, gamma, avg, iterations, batch, anti };
+}
+
+// Idem, avec la variable de contrôle `control`, cf `src/variance_reduction.hpp`.
+template<class Phi, class Gamma, class H>
+auto stochastic_gradient(
+    double alpha,
+    int iterations,
+    const Phi & phi,
+    const Gamma & gamma,
+    control_variate<H> control,
+    averaging avg = averaging::no,
+    antithetic anti = antithetic::no
+) -> approx_kernel<Phi, Gamma, control_variate<H>>
+{
+    return approx_kernel<Phi, Gamma, control_variate<H>> {
+        alpha,
+        phi,
+        gamma,
+        avg,
+        iterations,
+        1,
+        anti,
+        control
+    };
 }
 
 // Cf plus haut, idem mais pour `IS_kernel`.
@@ -167,7 +838,8 @@ auto importance_sampling(
     int iterations,
     const Phi & phi = identity,
     const Gamma & gamma = steps::inverse,
-    averaging avg = averaging::no
+    averaging avg = averaging::no,
+    switching sw = switching::fixed
 ) -> IS_kernel<Phi, Gamma>
 {
     return IS_kernel<Phi, Gamma> {
@@ -177,7 +849,51 @@ auto importance_sampling(
         gamma,
         avg,
         iterations,
+        sw
     };
 }
 
+// Cf plus haut, idem mais pour `levels_kernel`.
+template<
+    class Phi = decltype(identity),
+    class Gamma = decltype(steps::inverse)
+>
+auto stochastic_gradient_levels(
+    std::vector<double> alphas,
+    int iterations,
+    const Phi & phi = identity,
+    const Gamma & gamma = steps::inverse,
+    averaging avg = averaging::no
+) -> levels_kernel<Phi, Gamma>
+{
+    return levels_kernel<Phi, Gamma> { std::move(alphas), phi, gamma, avg, iterations };
+}
+
+// Cf plus haut, idem mais pour `portfolios_kernel`.
+template<class Phi, class Gamma = decltype(steps::inverse)>
+auto stochastic_gradient_portfolios(
+    double alpha,
+    int iterations,
+    const std::vector<Phi> & phis,
+    const Gamma & gamma = steps::inverse,
+    averaging avg = averaging::no
+) -> portfolios_kernel<Phi, Gamma>
+{
+    return portfolios_kernel<Phi, Gamma> { alpha, phis, gamma, avg, iterations };
+}
+
+// Cf plus haut, idem mais pour `empirical_kernel`. Par défaut, on garde au plus $2^{26}$
+// pertes en mémoire (512 Mo).
+template<class Phi = decltype(identity)>
+auto empirical_estimate(
+    double alpha,
+    long long samples,
+    const Phi & phi = identity,
+    int threads = detail::default_threads(),
+    std::size_t memory = std::size_t { 1 } << 26
+) -> empirical_kernel<Phi>
+{
+    return empirical_kernel<Phi> { alpha, phi, samples, threads, memory };
+}
+
 #endif
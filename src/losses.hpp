@@ -0,0 +1,262 @@
+#ifndef LOSSES_HPP
+#define LOSSES_HPP
+
+#include "detail/vmath.hpp"
+#include <vector>
+#include <cstddef> // `std::size_t`
+#include <cmath> // `std::exp`, `std::sqrt`
+#include <algorithm> // `std::max`
+#include <utility> // `std::move`
+
+// Fonctions de perte $\phi$ pour des portefeuilles d'options sur un facteur de Black-Scholes, à
+// passer aux noyaux de `src/estimate.hpp`. En plus de l'appel `phi(x)`, chaque fonction de
+// perte offre une évaluation par blocs `phi.evaluate(x, out, n)`, qui écrit dans `out[i]` la
+// perte pour le tirage `x[i]`: les boucles sur le bloc ne contiennent ni branchement ni appel à
+// `std::exp` (cf `src/detail/vmath.hpp`), et sont vectorisées par le compilateur. Les noyaux
+// utilisent l'évaluation par blocs lorsqu'elle existe, cf `src/detail/losses.hpp`.
+//
+// Une position de quantité `quantity` (négative pour une position courte) sur un instrument de
+// paiement $f(S_T)$ à l'échéance, acheté au prix `premium`, a pour perte à l'échéance
+// $-quantity \times (f(S_T) - e^{rT} premium)$. Par exemple, la perte de `short_put.cpp` est
+// celle de `european_put { model, 110, -1, 10.7 }` avec `model = { 100, 0.2, 0.05, 1 }`.
+namespace losses {
+
+// Facteur de Black-Scholes: le sous-jacent à l'échéance vaut
+// $S_T = spot \times e^{(rate - vol^2 / 2) T + vol \sqrt{T} x}$, $x$ étant un tirage de loi
+// normale centrée réduite.
+struct black_scholes {
+    double spot, vol, rate, maturity;
+
+    auto underlying(double x) const -> double {
+        return spot * std::exp(drift() + diffusion() * x);
+    }
+
+    // Écrit dans `S[i]` la valeur du sous-jacent pour le tirage `x[i]`.
+    void underlying(const double * x, double * S, std::size_t n) const {
+        auto a = drift(), b = diffusion();
+        for (std::size_t i = 0; i < n; ++i)
+            S[i] = spot * detail::fast_exp(a + b * x[i]);
+    }
+
+    // Facteur de capitalisation $e^{rT}$ des primes.
+    auto growth() const -> double {
+        return std::exp(rate * maturity);
+    }
+
+    auto drift() const -> double {
+        return (rate - vol * vol / 2) * maturity;
+    }
+
+    auto diffusion() const -> double {
+        return vol * std::sqrt(maturity);
+    }
+};
+
+// Base commune des instruments: `Derived::payoff(S)` donne le paiement à l'échéance, sous une
+// forme sans branchement.
+template<class Derived>
+class instrument {
+    private:
+        // Taille des blocs intermédiaires de `evaluate`.
+        static constexpr std::size_t block = 256;
+
+    protected:
+        black_scholes model;
+        double quantity, premium;
+
+    public:
+        instrument(black_scholes model, double quantity, double premium) :
+            model(model), quantity { quantity }, premium { premium }
+        {
+        }
+
+        auto operator ()(double x) const -> double {
+            const auto & self = static_cast<const Derived &>(*this);
+            return -quantity * (self.payoff(model.underlying(x)) - model.growth() * premium);
+        }
+
+        void evaluate(const double * x, double * out, std::size_t n) const {
+            const auto & self = static_cast<const Derived &>(*this);
+            auto cost = model.growth() * premium;
+            double S[block];
+            for (std::size_t start = 0; start < n; start += block) {
+                auto count = n - start < block ? n - start : block;
+                model.underlying(x + start, S, count);
+                for (std::size_t i = 0; i < count; ++i)
+                    out[start + i] = -quantity * (self.payoff(S[i]) - cost);
+            }
+        }
+};
+
+// Option de vente européenne de strike `strike`.
+class european_put : public instrument<european_put> {
+    private:
+        double strike;
+
+    public:
+        // Paramètres du constructeur:
+        // * `model`: facteur de Black-Scholes du sous-jacent
+        // * `strike`: prix d'exercice
+        // * `quantity`: nombre d'options détenues, négatif pour une position courte
+        // * `premium`: prix payé (ou reçu) par option
+        european_put(black_scholes model, double strike, double quantity, double premium) :
+            instrument { model, quantity, premium }, strike { strike }
+        {
+        }
+
+        auto payoff(double S) const -> double {
+            return std::max(strike - S, 0.);
+        }
+};
+
+// Option d'achat européenne, cf `european_put`.
+class european_call : public instrument<european_call> {
+    private:
+        double strike;
+
+    public:
+        european_call(black_scholes model, double strike, double quantity, double premium) :
+            instrument { model, quantity, premium }, strike { strike }
+        {
+        }
+
+        auto payoff(double S) const -> double {
+            return std::max(S - strike, 0.);
+        }
+};
+
+// Contrat à terme de prix de livraison `strike`, sans prime.
+class forward : public instrument<forward> {
+    private:
+        double strike;
+
+    public:
+        forward(black_scholes model, double strike, double quantity) :
+            instrument { model, quantity, 0. }, strike { strike }
+        {
+        }
+
+        auto payoff(double S) const -> double {
+            return S - strike;
+        }
+};
+
+// Position sur le sous-jacent lui-même, acheté au prix `spot` du modèle.
+class linear : public instrument<linear> {
+    public:
+        linear(black_scholes model, double quantity) :
+            instrument { model, quantity, model.spot }
+        {
+        }
+
+        auto payoff(double S) const -> double {
+            return S;
+        }
+};
+
+// Type d'une ligne de `portfolio`.
+enum class position_kind {
+    put,
+    call,
+    forward,
+    linear,
+};
+
+// Ligne de `portfolio`: mêmes paramètres que les instruments ci-dessus (`strike` et `premium`
+// sont ignorés lorsqu'ils n'ont pas de sens).
+struct position {
+    position_kind kind;
+    double strike, quantity, premium;
+};
+
+// Portefeuille de positions sur le même sous-jacent, dont la perte est la somme des pertes des
+// positions. Le sous-jacent n'est calculé qu'une fois par tirage, puis chaque position ajoute
+// sa perte au bloc par une boucle qui lui est propre.
+class portfolio {
+    private:
+        static constexpr std::size_t block = 256;
+
+        black_scholes model;
+        std::vector<position> positions;
+
+        // Paiement de `p` pour le sous-jacent `S`.
+        static auto payoff(const position & p, double S) -> double {
+            switch (p.kind) {
+                case position_kind::put:
+                    return std::max(p.strike - S, 0.);
+                case position_kind::call:
+                    return std::max(S - p.strike, 0.);
+                case position_kind::forward:
+                    return S - p.strike;
+                default:
+                    return S;
+            }
+        }
+
+        // Coût capitalisé d'une unité de `p`.
+        auto cost(const position & p) const -> double {
+            switch (p.kind) {
+                case position_kind::forward:
+                    return 0;
+                case position_kind::linear:
+                    return model.growth() * model.spot;
+                default:
+                    return model.growth() * p.premium;
+            }
+        }
+
+    public:
+        explicit portfolio(black_scholes model, std::vector<position> positions = { }) :
+            model(model), positions(std::move(positions))
+        {
+        }
+
+        void add(position p) {
+            positions.push_back(p);
+        }
+
+        auto operator ()(double x) const -> double {
+            auto S = model.underlying(x);
+            double result = 0;
+            for (const auto & p : positions)
+                result -= p.quantity * (payoff(p, S) - cost(p));
+            return result;
+        }
+
+        void evaluate(const double * x, double * out, std::size_t n) const {
+            double S[block];
+            for (std::size_t start = 0; start < n; start += block) {
+                auto count = n - start < block ? n - start : block;
+                auto o = out + start;
+                model.underlying(x + start, S, count);
+                for (std::size_t i = 0; i < count; ++i)
+                    o[i] = 0;
+                // Une boucle par position, dont le type est fixé: le `switch` est hors boucle.
+                for (const auto & p : positions) {
+                    auto q = p.quantity, K = p.strike, c = cost(p);
+                    switch (p.kind) {
+                        case position_kind::put:
+                            for (std::size_t i = 0; i < count; ++i)
+                                o[i] -= q * (std::max(K - S[i], 0.) - c);
+                            break;
+                        case position_kind::call:
+                            for (std::size_t i = 0; i < count; ++i)
+                                o[i] -= q * (std::max(S[i] - K, 0.) - c);
+                            break;
+                        case position_kind::forward:
+                            for (std::size_t i = 0; i < count; ++i)
+                                o[i] -= q * (S[i] - K);
+                            break;
+                        default:
+                            for (std::size_t i = 0; i < count; ++i)
+                                o[i] -= q * (S[i] - c);
+                            break;
+                    }
+                }
+            }
+        }
+};
+
+}
+
+#endif
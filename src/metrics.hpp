@@ -0,0 +1,134 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <chrono>
+#include <cmath> // `std::isfinite`
+#include <limits>
+#include <ostream>
+
+// Mesures facultatives d'un calcul par importance sampling (cf `IS_kernel::measure` dans
+// `src/estimate.hpp`), pour comprendre un calcul qui se comporte mal:
+// * pour chaque phase: durée, nombre de pas et débit, et proportion des tirages tombés dans la
+//   queue, c'est-à-dire $\phi(X - \theta_n) \geq \xi_n$ en phase 1 (soit $L3 \neq 0$, comme
+//   pour `detail::phase1_monitor`) et $\phi(X + \theta) \geq \xi_n$ en phase 2;
+// * en phase 1, nombre de pas où $L3$ ou $L4$ ne sont pas finis, typiquement parce que
+//   l'exponentielle de `IS_params::W` a débordé;
+// * en phase 2, moyenne et maximum des rapports de vraisemblance $w = \frac{p(X + \theta)}{p(X)}$
+//   (`IS_params::incr`), et taille effective d'échantillon $\frac{(\sum w)^2}{\sum w^2}$.
+// Sans mesures, les suites ne font qu'un test de pointeur nul par pas. Avec, la phase 2
+// évalue une fois de plus $\phi$ et le rapport de vraisemblance à chaque pas.
+// Les mesures sont écrites au format JSON, sur une ligne, par `write_json`; avec `every > 0`,
+// elles le sont aussi tous les `every` pas (mesures partielles de la phase en cours).
+class IS_metrics {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct phase_metrics {
+            long long steps = 0, hits = 0, overflows = 0;
+            double weight_sum = 0, weight_square_sum = 0, weight_max = 0;
+            clock::time_point start;
+            double seconds = 0;
+            bool running = false;
+        };
+
+        phase_metrics phases[2];
+        std::ostream * out;
+        long long every, pending = 0;
+
+        // Les flottants non finis n'existent pas en JSON.
+        static void number(std::ostream & os, double x) {
+            if (std::isfinite(x))
+                os << x;
+            else
+                os << "null";
+        }
+
+        auto seconds(const phase_metrics & p) const -> double {
+            if (!p.running)
+                return p.seconds;
+            return std::chrono::duration<double> { clock::now() - p.start }.count();
+        }
+
+        void tick() {
+            if (every > 0 && ++pending == every) {
+                pending = 0;
+                write_json(*out);
+            }
+        }
+
+        void write_phase(std::ostream & os, int phase) const {
+            const auto & p = phases[phase];
+            auto time = seconds(p);
+            auto steps = static_cast<double>(p.steps);
+            os << "{\"steps\":" << p.steps << ",\"seconds\":";
+            number(os, time);
+            os << ",\"samples_per_second\":";
+            number(os, time > 0 ? steps / time : std::numeric_limits<double>::quiet_NaN());
+            os << ",\"tail_hits\":" << p.hits << ",\"tail_rate\":";
+            number(os, p.hits / steps);
+            if (phase == 0) {
+                os << ",\"overflows\":" << p.overflows << "}";
+                return;
+            }
+            os << ",\"likelihood_ratio\":{\"mean\":";
+            number(os, p.weight_sum / steps);
+            os << ",\"max\":";
+            number(os, p.weight_max);
+            os << "},\"effective_sample_size\":";
+            number(os, p.weight_sum * p.weight_sum / p.weight_square_sum);
+            os << "}";
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `out`: flux des mesures périodiques (ignoré si `every == 0`)
+        // * `every`: nombre de pas entre deux mesures périodiques, 0 pour n'en écrire aucune
+        explicit IS_metrics(std::ostream * out = nullptr, long long every = 0) :
+            out(out), every { out == nullptr ? 0 : every }
+        {
+        }
+
+        // Début et fin de la phase `phase` (0 ou 1).
+        void begin(int phase) {
+            phases[phase].start = clock::now();
+            phases[phase].running = true;
+        }
+
+        void end(int phase) {
+            auto & p = phases[phase];
+            p.seconds = std::chrono::duration<double> { clock::now() - p.start }.count();
+            p.running = false;
+        }
+
+        // À appeler après chaque pas de la phase 1.
+        void phase1_step(bool hit, bool overflow) {
+            auto & p = phases[0];
+            ++p.steps;
+            p.hits += hit;
+            p.overflows += overflow;
+            tick();
+        }
+
+        // À appeler après chaque pas de la phase 2, avec le rapport de vraisemblance `weight`.
+        void phase2_step(bool hit, double weight) {
+            auto & p = phases[1];
+            ++p.steps;
+            p.hits += hit;
+            p.weight_sum += weight;
+            p.weight_square_sum += weight * weight;
+            p.weight_max = weight > p.weight_max ? weight : p.weight_max;
+            tick();
+        }
+
+        // Écrit `{"phase1":{...},"phase2":{...}}` puis un retour à la ligne.
+        void write_json(std::ostream & os) const {
+            os << "{\"phase1\":";
+            write_phase(os, 0);
+            os << ",\"phase2\":";
+            write_phase(os, 1);
+            os << "}\n";
+            os.flush();
+        }
+};
+
+#endif
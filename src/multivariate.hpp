@@ -0,0 +1,239 @@
+#ifndef MULTIVARIATE_HPP
+#define MULTIVARIATE_HPP
+
+#include <random>
+#include <vector>
+#include <string>
+#include <cstddef> // `std::size_t`
+#include <cmath> // `std::sqrt`
+#include <utility> // `std::move`
+#include <initializer_list>
+#include <istream>
+#include <ostream>
+
+// Facteurs de risque multidimensionnels, pour des portefeuilles qui dépendent de plusieurs
+// sous-jacents: la fonction de perte $\phi$ prend alors en argument un vecteur `factors`, tiré
+// selon la loi `gaussian_factors`. L'importance sampling de `src/estimate.hpp` fonctionne avec
+// ces facteurs, cf `src/detail/importance_sampling_parameters.hpp`.
+
+// Vecteur de facteurs, stocké de façon contiguë. Les opérations terme à terme sont de simples
+// boucles, que le compilateur vectorise; les opérateurs binaires réutilisent le stockage de
+// leur opérande de gauche lorsque c'est un temporaire.
+class factors {
+    private:
+        std::vector<double> values;
+
+    public:
+        factors() = default;
+
+        // Vecteur nul de dimension `dimension`.
+        explicit factors(std::size_t dimension) : values(dimension)
+        {
+        }
+
+        factors(std::initializer_list<double> values) : values(values)
+        {
+        }
+
+        auto size() const -> std::size_t {
+            return values.size();
+        }
+
+        auto data() -> double * {
+            return values.data();
+        }
+
+        auto data() const -> const double * {
+            return values.data();
+        }
+
+        auto operator [](std::size_t i) -> double & {
+            return values[i];
+        }
+
+        auto operator [](std::size_t i) const -> const double & {
+            return values[i];
+        }
+
+        auto operator +=(const factors & r) -> factors & {
+            for (std::size_t i = 0; i < values.size(); ++i)
+                values[i] += r.values[i];
+            return *this;
+        }
+
+        auto operator -=(const factors & r) -> factors & {
+            for (std::size_t i = 0; i < values.size(); ++i)
+                values[i] -= r.values[i];
+            return *this;
+        }
+
+        auto operator *=(double r) -> factors & {
+            for (auto & v : values)
+                v *= r;
+            return *this;
+        }
+
+        auto operator /=(double r) -> factors & {
+            for (auto & v : values)
+                v /= r;
+            return *this;
+        }
+
+        friend auto operator ==(const factors & l, const factors & r) -> bool {
+            return l.values == r.values;
+        }
+
+        // Dimension, puis composantes, séparées par des espaces (pour les sauvegardes de
+        // `src/checkpoint.hpp`).
+        friend auto operator <<(std::ostream & os, const factors & f) -> std::ostream & {
+            os << f.values.size();
+            for (auto v : f.values)
+                os << ' ' << v;
+            return os;
+        }
+
+        friend auto operator >>(std::istream & is, factors & f) -> std::istream & {
+            std::size_t dimension;
+            if (is >> dimension) {
+                f.values.resize(dimension);
+                for (auto & v : f.values)
+                    is >> v;
+            }
+            return is;
+        }
+};
+
+inline auto operator +(factors l, const factors & r) -> factors {
+    return l += r;
+}
+
+inline auto operator -(factors l, const factors & r) -> factors {
+    return l -= r;
+}
+
+inline auto operator *(double l, factors r) -> factors {
+    return r *= l;
+}
+
+inline auto operator *(factors l, double r) -> factors {
+    return l *= r;
+}
+
+// Produit scalaire.
+inline auto dot(const factors & l, const factors & r) -> double {
+    double result = 0;
+    for (std::size_t i = 0; i < l.size(); ++i)
+        result += l[i] * r[i];
+    return result;
+}
+
+// Loi normale multidimensionnelle de moyenne `mean` et de matrice de covariance $\Sigma$
+// (définie positive). On calcule une fois pour toutes la factorisation de Cholesky
+// $\Sigma = L L^T$, $L$ triangulaire inférieure; un tirage est alors $x = mean + L z$, $z$ étant
+// un vecteur de normales centrées réduites indépendantes.
+class gaussian_factors {
+    private:
+        factors center;
+        std::vector<double> lower; // $L$, ligne par ligne
+        std::normal_distribution<> unit;
+
+    public:
+        using result_type = factors;
+
+        // Paramètres du constructeur:
+        // * `mean`: moyenne, de dimension $d$
+        // * `covariance`: matrice de covariance $d \times d$, ligne par ligne
+        gaussian_factors(factors mean, const std::vector<double> & covariance) :
+            center(std::move(mean)), lower(center.size() * center.size())
+        {
+            auto d = center.size();
+            if (covariance.size() != d * d)
+                throw std::string { "covariance matrix does not match the mean" };
+            for (std::size_t i = 0; i < d; ++i) {
+                for (std::size_t j = 0; j <= i; ++j) {
+                    auto sum = covariance[i * d + j];
+                    for (std::size_t k = 0; k < j; ++k)
+                        sum -= lower[i * d + k] * lower[j * d + k];
+                    if (i == j) {
+                        if (!(sum > 0))
+                            throw std::string { "covariance matrix is not positive definite" };
+                        lower[i * d + i] = std::sqrt(sum);
+                    } else {
+                        lower[i * d + j] = sum / lower[j * d + j];
+                    }
+                }
+            }
+        }
+
+        auto dimension() const -> std::size_t {
+            return center.size();
+        }
+
+        auto mean() const -> const factors & {
+            return center;
+        }
+
+        // Écrit $mean + L z$ dans `x`.
+        void correlate(const double * z, double * x) const {
+            auto d = dimension();
+            for (std::size_t i = 0; i < d; ++i) {
+                const auto * row = lower.data() + i * d;
+                double sum = 0;
+                for (std::size_t k = 0; k <= i; ++k)
+                    sum += row[k] * z[k];
+                x[i] = center[i] + sum;
+            }
+        }
+
+        // Écrit $L^{-1} v$ dans `z` (descente triangulaire); `v` et `z` peuvent être égaux.
+        void whiten(const double * v, double * z) const {
+            auto d = dimension();
+            for (std::size_t i = 0; i < d; ++i) {
+                const auto * row = lower.data() + i * d;
+                auto sum = v[i];
+                for (std::size_t k = 0; k < i; ++k)
+                    sum -= row[k] * z[k];
+                z[i] = sum / row[i];
+            }
+        }
+
+        template<class Generator>
+        auto operator ()(Generator & g) -> factors {
+            factors z(dimension()), x(dimension());
+            for (std::size_t i = 0; i < dimension(); ++i)
+                z[i] = unit(g);
+            correlate(z.data(), x.data());
+            return x;
+        }
+
+        void reset() {
+            unit.reset();
+        }
+
+        // Seul l'état de la loi normale sous-jacente est sauvegardé: les paramètres font
+        // partie de la description du calcul.
+        friend auto operator <<(std::ostream & os, const gaussian_factors & d) -> std::ostream & {
+            return os << d.unit;
+        }
+
+        friend auto operator >>(std::istream & is, gaussian_factors & d) -> std::istream & {
+            return is >> d.unit;
+        }
+};
+
+// Covariance de `dimension` facteurs de même écart-type `stddev`, deux à deux corrélés avec le
+// coefficient `correlation`.
+inline auto equicorrelated(
+    std::size_t dimension,
+    double stddev,
+    double correlation
+) -> std::vector<double>
+{
+    std::vector<double> covariance(dimension * dimension);
+    for (std::size_t i = 0; i < dimension; ++i)
+        for (std::size_t j = 0; j < dimension; ++j)
+            covariance[i * dimension + j] = stddev * stddev * (i == j ? 1 : correlation);
+    return covariance;
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "detail/thread_pool.hpp"
+#include "detail/streams.hpp"
+#include "detail/iterate.hpp"
+#include "stopping.hpp"
+#include <vector>
+#include <string>
+#include <utility> // `std::pair`
+
+// Résultat d'un calcul par réplicas indépendants.
+struct replicated_estimate {
+    double xi, C; // moyennes des estimations de la V@R et CV@R de chaque réplica
+    double xi_error, C_error; // erreurs standard associées
+};
+
+// Exécute `replicas` copies indépendantes d'un noyau de calcul (`approx_kernel` ou `IS_kernel`)
+// sur un groupe de threads, puis fusionne les résultats. Le budget total d'itérations du
+// noyau est réparti entre les réplicas: chaque réplica fait `iterations / replicas`
+// itérations.
+template<class Kernel>
+class replicated_kernel {
+    private:
+        Kernel kernel;
+        int replicas, threads;
+
+    public:
+        // Paramètres du constructeur:
+        // * `kernel`: noyau de calcul à répliquer
+        // * `replicas`: nombre de suites indépendantes
+        // * `threads`: nombre de threads à utiliser
+        replicated_kernel(const Kernel & kernel, int replicas, int threads) :
+            kernel { kernel }, replicas { replicas }, threads { threads }
+        {
+        }
+
+        // Paramètres génériques d'un noyau de calcul: cf `approx_kernel::compute`.
+        // Chaque réplica travaille sur sa propre copie de `d` et sur son propre générateur,
+        // initialisé à partir de `g`. Les graines sont tirées séquentiellement avant de
+        // lancer les threads, donc le résultat ne dépend pas du nombre de threads.
+        template<class Distribution, class Generator>
+        auto compute(Distribution & d, Generator & g) -> replicated_estimate {
+            detail::no_observer observer;
+            return compute(d, g, observer);
+        }
+
+        // Idem, chaque réplica recevant sa propre copie de l'observateur `observer`.
+        template<class Distribution, class Generator, class Observer>
+        auto compute(
+            Distribution & d,
+            Generator & g,
+            const Observer & observer
+        ) -> replicated_estimate {
+            return run(d, g, threads, [&](int) { return observer; }, [](int, double, double) { });
+        }
+
+        // Idem, avec le critère d'arrêt `rule` de `src/stopping.hpp` (construit pour
+        // `replicas` réplicas): les réplicas s'attendent à chaque point de contrôle, chacun
+        // s'exécute donc sur son propre thread, quel que soit `threads`. Le résultat ne dépend
+        // toujours pas du nombre de threads.
+        template<class Distribution, class Generator>
+        auto compute(Distribution & d, Generator & g, tolerance & rule) -> replicated_estimate {
+            if (rule.replica_count() != replicas)
+                throw std::string { "stopping rule built for another number of replicas" };
+            return run(
+                d,
+                g,
+                replicas,
+                [&](int r) { return rule.replica(r); },
+                [&](int r, double xi, double C) { rule.leave(r, xi, C); }
+            );
+        }
+
+    private:
+        // Exécute les réplicas sur `count` threads: le réplica `r` reçoit l'observateur
+        // `observer_for(r)`, et l'on appelle `done(r, xi, C)` avec son résultat.
+        template<class Distribution, class Generator, class ObserverFor, class Done>
+        auto run(
+            Distribution & d,
+            Generator & g,
+            int count,
+            const ObserverFor & observer_for,
+            const Done & done
+        ) -> replicated_estimate {
+            std::vector<Generator> generators;
+            for (int r = 0; r < replicas; ++r)
+                generators.push_back(detail::split(g));
+
+            auto shard = kernel.per_replica(replicas);
+            std::vector<std::pair<double, double>> results(replicas);
+            detail::parallel_for(replicas, count, [&](int r) {
+                auto local_kernel = shard;
+                auto local_d = d;
+                local_d.reset();
+                auto local_observer = observer_for(r);
+                results[r] = local_kernel.compute(local_d, generators[r], local_observer);
+                done(r, results[r].first, results[r].second);
+            });
+
+            auto merged = detail::mean_and_error(results);
+            return replicated_estimate {
+                merged.first.first,
+                merged.first.second,
+                merged.second.first,
+                merged.second.second,
+            };
+        }
+};
+
+// Fonction utilitaire pour inférer les paramètres template de `replicated_kernel`, cf
+// `src/estimate.hpp/stochastic_gradient`.
+template<class Kernel>
+auto replicate(
+    const Kernel & kernel,
+    int replicas,
+    int threads = detail::default_threads()
+) -> replicated_kernel<Kernel>
+{
+    return replicated_kernel<Kernel> { kernel, replicas, threads };
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "detail/ring.hpp"
+#include "detail/losses.hpp"
+#include "detail/streams.hpp"
+#include <thread>
+#include <atomic>
+#include <memory> // `std::unique_ptr`
+#include <vector>
+#include <string>
+#include <cstddef> // `std::size_t`
+
+// Exécution en pipeline de l'algorithme naïf de la section 2: la récurrence sur $(\xi_n, C_n)$
+// est intrinsèquement séquentielle, mais le tirage de $X$ et l'évaluation de $\phi(X)$, souvent
+// bien plus coûteux, peuvent être faits à l'avance sur d'autres threads. Les pertes arrivent
+// alors à la récurrence par blocs, comme celles d'un fichier de pertes précalculées (cf
+// `src/stream.hpp` et `approx_kernel::consume`), cf `approx_kernel::pipelined_compute`.
+
+// Taille par défaut des blocs: $2^{14}$ pertes (128 Ko, qui tiennent dans le cache L2).
+constexpr std::size_t pipeline_block = 1 << 14;
+
+// Nombre par défaut de blocs d'avance de chaque producteur.
+constexpr std::size_t pipeline_depth = 8;
+
+// Source de `samples` pertes $\phi(X_i)$ tirées par `producers` threads. Chaque producteur
+// remplit sa propre file `detail::spsc_ring` de blocs de pertes, que le consommateur (le thread
+// qui appelle `next_chunk`) lit à tour de rôle: le bloc `k` vient du producteur
+// `k % producers`.
+// Avec un seul producteur, les pertes sont tirées avec `d` et `g` eux-mêmes, et sont donc
+// exactement celles qu'aurait tirées `approx_kernel::compute`. Sinon, chaque producteur a sa
+// propre copie de `d` et son propre générateur, tiré de `g` à la construction (cf
+// `detail::split`): les pertes dépendent du nombre de producteurs, mais pas de l'ordonnancement
+// des threads.
+template<class Phi, class Distribution, class Generator>
+class pipelined_losses {
+    private:
+        struct block {
+            std::vector<double> losses;
+            std::size_t size;
+        };
+
+        using ring = detail::spsc_ring<block>;
+
+        const Phi & phi;
+        std::size_t samples, block_size;
+        std::size_t next = 0; // numéro du prochain bloc à lire
+        ring * current = nullptr; // file du dernier bloc lu, pas encore libéré
+        std::vector<Distribution> distributions;
+        std::vector<Generator> generators;
+        std::vector<std::unique_ptr<ring>> rings;
+        std::vector<std::thread> threads;
+        std::atomic<bool> stop { false };
+
+        // Tire les blocs `p`, `p + producers`, ..., en attendant qu'une case se libère lorsque
+        // la file est pleine.
+        void produce(std::size_t p, Distribution & d, Generator & g) {
+            detail::loss_sampler<Phi, Distribution, Generator> sample { phi, d, g };
+            auto count = (samples + block_size - 1) / block_size;
+            for (auto k = p; k < count; k += rings.size()) {
+                block * b;
+                while ((b = rings[p]->back()) == nullptr) {
+                    if (stop.load(std::memory_order_relaxed))
+                        return;
+                    std::this_thread::yield();
+                }
+                b->size = k * block_size + block_size <= samples
+                    ? block_size
+                    : samples - k * block_size;
+                sample.fill(b->losses.data(), b->size);
+                rings[p]->push();
+            }
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `phi`, `d`, `g`: cf `approx_kernel::compute`; `d` et `g` sont utilisés par le
+        //   producteur tant que la source existe
+        // * `samples`: nombre total de pertes
+        // * `producers`: nombre de threads producteurs
+        // * `block_size`, `depth`: taille des blocs, et nombre de blocs d'avance de chaque
+        //   producteur
+        pipelined_losses(
+            const Phi & phi,
+            Distribution & d,
+            Generator & g,
+            std::size_t samples,
+            int producers = 1,
+            std::size_t block_size = pipeline_block,
+            std::size_t depth = pipeline_depth
+        ) : phi(phi), samples { samples }, block_size { block_size }
+        {
+            if (producers <= 0)
+                throw std::string { "bad number of producers" };
+            for (int p = 0; p < producers; ++p) {
+                auto empty = block { std::vector<double>(block_size), 0 };
+                rings.emplace_back(new ring { depth, empty });
+                if (producers > 1) {
+                    distributions.push_back(d);
+                    distributions.back().reset();
+                    generators.push_back(detail::split(g));
+                }
+            }
+            for (int p = 0; p < producers; ++p) {
+                auto local_d = producers == 1 ? &d : &distributions[p];
+                auto local_g = producers == 1 ? &g : &generators[p];
+                threads.emplace_back([this, p, local_d, local_g]() {
+                    produce(static_cast<std::size_t>(p), *local_d, *local_g);
+                });
+            }
+        }
+
+        pipelined_losses(const pipelined_losses &) = delete;
+        auto operator =(const pipelined_losses &) -> pipelined_losses & = delete;
+
+        // Arrête les producteurs, par exemple si le consommateur s'est arrêté avant la fin.
+        ~pipelined_losses() {
+            stop = true;
+            for (auto & t : threads)
+                t.join();
+        }
+
+        // Cf `src/stream.hpp`: le bloc reste valable jusqu'à l'appel suivant.
+        auto next_chunk(const double * & data) -> std::size_t {
+            if (current != nullptr) {
+                current->pop();
+                current = nullptr;
+            }
+            if (next * block_size >= samples)
+                return 0;
+
+            auto & r = *rings[next % rings.size()];
+            block * b;
+            while ((b = r.front()) == nullptr)
+                std::this_thread::yield();
+            ++next;
+            current = &r;
+            data = b->losses.data();
+            return b->size;
+        }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef QMC_HPP
+#define QMC_HPP
+
+#include "detail/quantile.hpp"
+#include <random>
+#include <cstdint>
+#include <cmath> // `std::log`
+#include <istream>
+#include <ostream>
+
+// Entrées quasi-Monte Carlo randomisées pour les noyaux de `src/estimate.hpp`: le générateur
+// `sobol` produit une suite de Sobol brouillée, et les distributions de ce fichier la
+// transforment par inversion de la fonction de répartition, en consommant exactement un mot de
+// 32 bits par tirage (les distributions de <random> en consomment un nombre variable, ce qui
+// détruirait la structure de la suite). On s'en sert comme `d` et `g` dans
+// `approx_kernel::compute` et `IS_kernel::compute`; pour des barres d'erreur, on passe par
+// `replicate` (cf `src/parallel.hpp`), chaque réplica recevant un brouillage indépendant.
+namespace qmc {
+
+// Suite de Sobol en dimension 1 (qui est la suite de van der Corput en base 2: le $i$-ième
+// point a pour bits ceux de $i$ renversés), brouillée à la Owen. On utilise le brouillage par
+// hachage de Burley ("Practical hash-based Owen scrambling", 2020): renverser les bits, appliquer
+// une permutation de Laine-Karras dont chaque bit de sortie ne dépend que des bits de poids
+// inférieur, puis renverser à nouveau. Chaque valeur de `scrambling` donne un brouillage
+// différent; les $2^m$ premiers points restent un $(0, m, 1)$-réseau pour tout brouillage.
+// Satisfait les exigences d'un générateur de la bibliothèque standard.
+class sobol {
+    public:
+        using result_type = std::uint32_t;
+
+    private:
+        std::uint64_t scrambling;
+        std::uint32_t seed;
+        std::uint64_t index = 0;
+
+        // Finaliseur de splitmix64, pour que des valeurs voisines de `scrambling` donnent des
+        // permutations sans rapport.
+        static auto hash(std::uint64_t x) -> std::uint32_t {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return static_cast<std::uint32_t>(x >> 32);
+        }
+
+        static auto reverse(std::uint32_t x) -> std::uint32_t {
+            x = (x << 16) | (x >> 16);
+            x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+            x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+            x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+            x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+            return x;
+        }
+
+        static auto laine_karras(std::uint32_t x, std::uint32_t seed) -> std::uint32_t {
+            x += seed;
+            x ^= x * 0x6c50b47c;
+            x ^= x * 0xb82f1e52;
+            x ^= x * 0xc7afe638;
+            x ^= x * 0x8d22f6e6;
+            return x;
+        }
+
+    public:
+        static constexpr auto min() -> result_type {
+            return 0;
+        }
+
+        static constexpr auto max() -> result_type {
+            return 0xffffffff;
+        }
+
+        // Paramètres du constructeur:
+        // * `scrambling`: numéro du brouillage
+        explicit sobol(std::uint64_t scrambling = 0) :
+            scrambling { scrambling }, seed { hash(scrambling) }
+        {
+        }
+
+        // Le $i$-ième point non brouillé vaut `reverse(i)`: le brouiller revient à renverser
+        // `laine_karras(i, seed)`.
+        auto operator ()() -> result_type {
+            return reverse(laine_karras(static_cast<std::uint32_t>(index++), seed));
+        }
+
+        void discard(unsigned long long z) {
+            index += z;
+        }
+
+        friend auto operator ==(const sobol & l, const sobol & r) -> bool {
+            return l.scrambling == r.scrambling && l.index == r.index;
+        }
+
+        friend auto operator !=(const sobol & l, const sobol & r) -> bool {
+            return !(l == r);
+        }
+
+        // Sérialisation textuelle de l'état, cf `philox4x32` dans `src/random.hpp`.
+        friend auto operator <<(std::ostream & os, const sobol & g) -> std::ostream & {
+            return os << g.scrambling << ' ' << g.index;
+        }
+
+        friend auto operator >>(std::istream & is, sobol & g) -> std::istream & {
+            std::uint64_t scrambling, index;
+            if (is >> scrambling >> index) {
+                g = sobol { scrambling };
+                g.discard(index);
+            }
+            return is;
+        }
+};
+
+// Uniforme dans $]0, 1[$ déduite d'un seul mot de 32 bits: le milieu de l'intervalle de
+// longueur $2^{-32}$ désigné par le mot.
+template<class Generator>
+auto uniform(Generator & g) -> double {
+    return (static_cast<std::uint32_t>(g()) + 0.5) * (1.0 / 4294967296.0);
+}
+
+// Loi normale par inversion: $x = \mu + \sigma \Phi^{-1}(u)$. Les paramètres, la comparaison
+// et la sérialisation sont ceux de `std::normal_distribution<>`, dont on hérite; ainsi
+// `detail::IS_params` se ramène au cas de la loi normale usuelle.
+class normal_distribution : public std::normal_distribution<> {
+    public:
+        explicit normal_distribution(double mean = 0., double stddev = 1.) :
+            std::normal_distribution<> { mean, stddev }
+        {
+        }
+
+        template<class Generator>
+        auto operator ()(Generator & g) -> double {
+            return mean() + stddev() * detail::normal_quantile(uniform(g));
+        }
+};
+
+// Loi exponentielle par inversion: $x = -\frac{\log(1 - u)}{\lambda}$, cf plus haut.
+class exponential_distribution : public std::exponential_distribution<> {
+    public:
+        explicit exponential_distribution(double lambda = 1.) :
+            std::exponential_distribution<> { lambda }
+        {
+        }
+
+        template<class Generator>
+        auto operator ()(Generator & g) -> double {
+            return -std::log(1 - uniform(g)) / lambda();
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+#include <cstddef> // `std::size_t`
+#include <istream>
+#include <ostream>
+
+// Générateur de nombres aléatoires à compteur Philox4x32-10 (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", 2011). La `k`-ième sortie est une fonction pure de la graine,
+// du numéro de flux et de `k`: on peut donc avancer de `z` tirages en temps constant (méthode
+// `discard`) et découper une même suite de tirages entre plusieurs threads ou processus sans
+// que le résultat change. Satisfait les exigences d'un générateur de la bibliothèque standard,
+// donc utilisable comme paramètre `g` des méthodes `compute` de `src/estimate.hpp`.
+class philox4x32 {
+    public:
+        using result_type = std::uint32_t;
+
+    private:
+        std::uint64_t key, stream_id, block = 0;
+        result_type buffer[4];
+        int index = 4;
+
+        static void round(std::uint32_t * ctr, const std::uint32_t * k) {
+            auto p0 = static_cast<std::uint64_t>(0xD2511F53) * ctr[0];
+            auto p1 = static_cast<std::uint64_t>(0xCD9E8D57) * ctr[2];
+            auto c0 = static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ k[0];
+            auto c2 = static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ k[1];
+            ctr[0] = c0;
+            ctr[1] = static_cast<std::uint32_t>(p1);
+            ctr[2] = c2;
+            ctr[3] = static_cast<std::uint32_t>(p0);
+        }
+
+        // Calcule les quatre sorties du bloc numéro `n`.
+        void compute_block(std::uint64_t n, result_type * out) const {
+            std::uint32_t ctr[4] = {
+                static_cast<std::uint32_t>(n),
+                static_cast<std::uint32_t>(n >> 32),
+                static_cast<std::uint32_t>(stream_id),
+                static_cast<std::uint32_t>(stream_id >> 32),
+            };
+            std::uint32_t k[2] = {
+                static_cast<std::uint32_t>(key),
+                static_cast<std::uint32_t>(key >> 32),
+            };
+            for (int r = 0; r < 10; ++r) {
+                if (r > 0) {
+                    k[0] += 0x9E3779B9;
+                    k[1] += 0xBB67AE85;
+                }
+                round(ctr, k);
+            }
+            for (int i = 0; i < 4; ++i)
+                out[i] = ctr[i];
+        }
+
+    public:
+        static constexpr auto min() -> result_type {
+            return 0;
+        }
+
+        static constexpr auto max() -> result_type {
+            return 0xffffffff;
+        }
+
+        // Paramètres du constructeur:
+        // * `seed`: graine, qui sert de clé au chiffrement
+        // * `stream`: numéro de flux; deux flux différents pour une même graine donnent des
+        //   suites indépendantes
+        explicit philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) :
+            key { seed }, stream_id { stream }
+        {
+        }
+
+        void seed(std::uint64_t s) {
+            key = s;
+            block = 0;
+            index = 4;
+        }
+
+        auto stream() const -> std::uint64_t {
+            return stream_id;
+        }
+
+        // Renvoie un générateur de même graine positionné au début du flux `s`.
+        auto substream(std::uint64_t s) const -> philox4x32 {
+            return philox4x32 { key, s };
+        }
+
+        auto operator ()() -> result_type {
+            if (index == 4) {
+                compute_block(block++, buffer);
+                index = 0;
+            }
+            return buffer[index++];
+        }
+
+        // Équivalent à `n` appels successifs à `operator ()`, mais les blocs complets sont
+        // calculés dans une boucle sans dépendance entre itérations.
+        void generate(result_type * out, std::size_t n) {
+            std::size_t i = 0;
+            while (i < n && index < 4)
+                out[i++] = buffer[index++];
+            for (; i + 4 <= n; i += 4)
+                compute_block(block++, out + i);
+            while (i < n)
+                out[i++] = (*this)();
+        }
+
+        // Avance de `z` tirages en temps constant.
+        void discard(unsigned long long z) {
+            // Position (en nombre de tirages) du prochain tirage.
+            auto position = 4 * block - (4 - index) + z;
+            block = position / 4;
+            index = 4;
+            auto offset = static_cast<int>(position % 4);
+            if (offset != 0) {
+                compute_block(block++, buffer);
+                index = offset;
+            }
+        }
+
+        friend auto operator ==(const philox4x32 & l, const philox4x32 & r) -> bool {
+            return l.key == r.key && l.stream_id == r.stream_id
+                && 4 * l.block - (4 - l.index) == 4 * r.block - (4 - r.index);
+        }
+
+        friend auto operator !=(const philox4x32 & l, const philox4x32 & r) -> bool {
+            return !(l == r);
+        }
+
+        // Sérialisation textuelle de l'état, sur le modèle des générateurs de <random>.
+        friend auto operator <<(std::ostream & os, const philox4x32 & g) -> std::ostream & {
+            return os << g.key << ' ' << g.stream_id << ' ' << 4 * g.block - (4 - g.index);
+        }
+
+        friend auto operator >>(std::istream & is, philox4x32 & g) -> std::istream & {
+            std::uint64_t key, stream, position;
+            if (is >> key >> stream >> position) {
+                g = philox4x32 { key, stream };
+                g.discard(position);
+            }
+            return is;
+        }
+};
+
+#endif
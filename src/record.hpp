@@ -0,0 +1,136 @@
+#ifndef RECORD_HPP
+#define RECORD_HPP
+
+#include "detail/state.hpp"
+#include <cstdint>
+#include <cstring> // `std::memcpy`, `std::strerror`
+#include <cerrno>
+#include <cmath> // `std::ceil`
+#include <string>
+#include <fcntl.h> // `open`
+#include <unistd.h> // `ftruncate`, `close`
+#include <sys/mman.h> // `mmap`, `munmap`
+
+// Format binaire des fichiers de trajectoire: un en-tête `trajectory_header`, suivi de
+// `capacity` emplacements `trajectory_record`, dont les `count` premiers sont remplis.
+struct trajectory_header {
+    char magic[8]; // "MCTRAJ1"
+    std::uint32_t version;
+    std::uint32_t record_size; // `sizeof(trajectory_record)`
+    std::uint64_t capacity;
+    std::uint64_t count;
+};
+
+constexpr std::uint32_t trajectory_version = 1;
+
+// Un terme de la suite observée. `phase` vaut 0 pour `approx_kernel` et pour la phase 1 de
+// `IS_kernel` ($(\xi_n, \theta_n, \mu_n)$), 1 pour la phase 2 ($(\xi_n, C_n)$); seules les
+// `size` premières valeurs de `values` sont significatives.
+struct trajectory_record {
+    std::uint32_t phase;
+    std::uint32_t size;
+    std::int64_t n;
+    double values[3];
+};
+
+// Observateur (cf `src/detail/iterate.hpp`) qui enregistre des termes de la trajectoire dans un
+// fichier projeté en mémoire. Le fichier est créé et dimensionné une fois pour toutes dans le
+// constructeur: l'enregistrement d'un terme n'est qu'une écriture en mémoire, sans allocation
+// ni appel système. On enregistre le terme $n$ puis le premier terme d'indice au moins
+// $\max(n + step, n \times ratio)$: `ratio = 1` donne un terme tous les `step`, `ratio > 1`
+// des termes espacés logarithmiquement. Une fois les `capacity` emplacements remplis, on
+// n'enregistre plus rien. L'observateur ne demande jamais l'arrêt.
+class trajectory_recorder {
+    private:
+        int fd = -1;
+        void * memory = nullptr;
+        std::size_t bytes = 0;
+        trajectory_header * header;
+        trajectory_record * records;
+
+        int step;
+        double ratio;
+        long long next_n = 0;
+        std::uint32_t phase = 0;
+        bool seen_any = false;
+
+        static auto error(const std::string & what, const std::string & path) -> std::string {
+            return what + " `" + path + "`: " + std::strerror(errno);
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `path`: fichier à créer (écrasé s'il existe)
+        // * `capacity`: nombre maximal de termes enregistrés
+        // * `step`, `ratio`: espacement des termes enregistrés, cf plus haut
+        trajectory_recorder(
+            const std::string & path,
+            std::uint64_t capacity,
+            int step = 1,
+            double ratio = 1.
+        ) : step { step < 1 ? 1 : step }, ratio { ratio < 1 ? 1 : ratio }
+        {
+            bytes = sizeof(trajectory_header) + capacity * sizeof(trajectory_record);
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                throw error("cannot open", path);
+            if (::ftruncate(fd, bytes) != 0) {
+                ::close(fd);
+                throw error("cannot resize", path);
+            }
+            memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (memory == MAP_FAILED) {
+                ::close(fd);
+                throw error("cannot map", path);
+            }
+
+            header = static_cast<trajectory_header *>(memory);
+            records = reinterpret_cast<trajectory_record *>(header + 1);
+            std::memcpy(header->magic, "MCTRAJ1", 8);
+            header->version = trajectory_version;
+            header->record_size = sizeof(trajectory_record);
+            header->capacity = capacity;
+            header->count = 0;
+        }
+
+        trajectory_recorder(const trajectory_recorder &) = delete;
+        auto operator =(const trajectory_recorder &) -> trajectory_recorder & = delete;
+
+        // Le fichier est tronqué aux seuls emplacements remplis.
+        ~trajectory_recorder() {
+            auto used = sizeof(trajectory_header) + header->count * sizeof(trajectory_record);
+            ::munmap(memory, bytes);
+            if (::ftruncate(fd, used) != 0) {
+                // Le fichier reste lisible: `count` indique le nombre d'emplacements valides.
+            }
+            ::close(fd);
+        }
+
+        template<std::size_t N>
+        auto operator ()(int n, const detail::state<N> & state) -> bool {
+            static_assert(N <= 3, "too many components to record");
+            // Un nouveau départ de `n` à 0 signale le passage à la phase suivante.
+            if (n == 0) {
+                if (seen_any)
+                    ++phase;
+                next_n = 0;
+            }
+            seen_any = true;
+            if (n < next_n || header->count == header->capacity)
+                return true;
+
+            auto & record = records[header->count];
+            record.phase = phase;
+            record.size = N;
+            record.n = n;
+            for (std::size_t i = 0; i < 3; ++i)
+                record.values[i] = i < N ? state[i] : 0;
+            ++header->count;
+
+            auto scaled = static_cast<long long>(std::ceil(n * ratio));
+            next_n = n + step > scaled ? n + step : scaled;
+            return true;
+        }
+};
+
+#endif
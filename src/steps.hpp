@@ -1,24 +1,219 @@
 #ifndef STEPS_HPP
 #define STEPS_HPP
 
-#include <cmath> // `std::pow`
-#include <functional> // `std::function`
+#include <cmath> // `std::pow`, `std::sqrt`
+#include <vector>
+#include <memory> // `std::shared_ptr`
+#include <cstddef> // `std::size_t`
 
 // Quelques exemples de suites $n \longmapsto \gamma_n$ respectant les hypothèses de l'article.
+// Chaque suite est un foncteur d'un type concret (et non un `std::function`), pour que le
+// compilateur puisse intégrer l'appel `gamma(n)` dans la boucle des noyaux de calcul. Les
+// indices sont des `long long`: une source de pertes précalculées (cf `src/stream.hpp`) peut
+// dépasser $2^{31}$ pas.
 namespace steps {
 
 // $n \longmapsto \frac{1}{n}$
-inline auto inverse(int n) -> double {
+inline auto inverse(long long n) -> double {
     return 1 / static_cast<double>(n);
 }
 
-// $n \longmapsto \frac{1}{n^a + offset}$
-// FIXME: retourne un objet `std::function<...>`, ce qui peut donner lieu à des allocations.
-// Le standard C++11 préconise d'éviter de telles allocations, mais ne l'impose pas.
-// En C++14, il suffirait de laisser le compilateur inférer un type à la fonction anonyme
-// retournée pour régler ça.
-inline auto inverse_pow(double a = 0.75, double offset = 100.0) -> std::function<double(int)> {
-    return [a, offset](int n) { return 1 / (std::pow(n, a) + offset); };
+// $n \longmapsto \frac{1}{n^a + offset}$, l'exposant `a` n'étant connu qu'à l'exécution.
+// Chaque appel coûte un `std::pow`: on préférera `fixed_pow` pour les exposants usuels.
+class power {
+    private:
+        double a, offset;
+
+    public:
+        power(double a, double offset) : a { a }, offset { offset }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return 1 / (std::pow(n, a) + offset);
+        }
+};
+
+// $n \longmapsto \frac{1}{n^{Num/Den} + offset}$, l'exposant étant connu à la compilation. Cas
+// général: on se ramène à `std::pow`, les spécialisations suivantes évitant cet appel.
+template<int Num, int Den>
+class fixed_pow {
+    private:
+        double offset;
+
+    public:
+        explicit fixed_pow(double offset = 0.) : offset { offset }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return 1 / (std::pow(n, static_cast<double>(Num) / Den) + offset);
+        }
+};
+
+// Exposant 1: $n \longmapsto \frac{1}{n + offset}$
+template<>
+class fixed_pow<1, 1> {
+    private:
+        double offset;
+
+    public:
+        explicit fixed_pow(double offset = 0.) : offset { offset }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return 1 / (n + offset);
+        }
+};
+
+// Exposant 3/4: $n^{3/4} = \sqrt{n} \sqrt{\sqrt{n}}$
+template<>
+class fixed_pow<3, 4> {
+    private:
+        double offset;
+
+    public:
+        explicit fixed_pow(double offset = 0.) : offset { offset }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            auto root = std::sqrt(static_cast<double>(n));
+            return 1 / (root * std::sqrt(root) + offset);
+        }
+};
+
+// Exposant 1/2: $n \longmapsto \frac{1}{\sqrt{n} + offset}$
+template<>
+class fixed_pow<1, 2> {
+    private:
+        double offset;
+
+    public:
+        explicit fixed_pow(double offset = 0.) : offset { offset }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return 1 / (std::sqrt(static_cast<double>(n)) + offset);
+        }
+};
+
+// Pas de Robbins-Monro classique $n \longmapsto \frac{c}{n + n_0}$.
+class robbins_monro {
+    private:
+        double c, n0;
+
+    public:
+        robbins_monro(double c, double n0 = 0.) : c { c }, n0 { n0 }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return c / (n + n0);
+        }
+};
+
+// Suite `Step` décalée de `shift` indices: $n \longmapsto \gamma_{n + shift}$. Permet de
+// démarrer avec des pas plus petits sans changer la forme de la suite.
+template<class Step>
+class shifted {
+    private:
+        Step step;
+        int shift;
+
+    public:
+        shifted(Step step, int shift) : step { step }, shift { shift }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return step(n + shift);
+        }
+};
+
+// Suite `Step` parcourue `factor` fois plus vite: $n \longmapsto factor \cdot \gamma_{factor \cdot n}$.
+// Le pas $n$ d'une suite parmi `factor` suites exécutées en parallèle tient lieu des pas
+// $factor \cdot n, ..., factor \cdot (n + 1) - 1$ d'une suite unique, cf
+// `IS_kernel::parallel_compute`.
+template<class Step>
+class scaled {
+    private:
+        Step step;
+        long long factor;
+
+    public:
+        scaled(Step step, long long factor) : step { step }, factor { factor }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return factor * step(factor * n);
+        }
+};
+
+// Suite définie par morceaux: `First` pour $n < n_0$, `Second` ensuite.
+template<class First, class Second>
+class piecewise {
+    private:
+        First first;
+        Second second;
+        int n0;
+
+    public:
+        piecewise(First first, Second second, int n0) :
+            first { first }, second { second }, n0 { n0 }
+        {
+        }
+
+        auto operator ()(long long n) const -> double {
+            return n < n0 ? first(n) : second(n);
+        }
+};
+
+// Suite `Step` dont les `size` premiers termes sont précalculés: un appel ne coûte alors plus
+// qu'une lecture en mémoire. La table est partagée entre les copies.
+template<class Step>
+class tabulated {
+    private:
+        Step step;
+        std::shared_ptr<std::vector<double>> table;
+
+    public:
+        tabulated(Step step, int size) :
+            step { step }, table { std::make_shared<std::vector<double>>(size) }
+        {
+            for (int n = 1; n < size; ++n)
+                (*table)[n] = step(n);
+        }
+
+        auto operator ()(long long n) const -> double {
+            if (static_cast<std::size_t>(n) < table->size())
+                return (*table)[n];
+            return step(n);
+        }
+};
+
+// $n \longmapsto \frac{1}{n^a + offset}$ avec `a` connu à l'exécution, cf `power`.
+inline auto inverse_pow(double a = 0.75, double offset = 100.0) -> power {
+    return power { a, offset };
+}
+
+// Appelle `f(gamma)` où `gamma` représente $n \longmapsto \frac{1}{n^a + offset}$, en
+// choisissant une seule fois le type le plus efficace selon la valeur de `a`: ainsi le choix
+// fait à l'exécution (par exemple via la ligne de commande) ne coûte rien dans la boucle de
+// calcul, qui est instanciée pour chaque type possible.
+template<class F>
+void dispatch(double a, double offset, const F & f) {
+    if (a == 1.)
+        f(fixed_pow<1, 1> { offset });
+    else if (a == 0.75)
+        f(fixed_pow<3, 4> { offset });
+    else if (a == 0.5)
+        f(fixed_pow<1, 2> { offset });
+    else
+        f(power { a, offset });
 }
 
 }
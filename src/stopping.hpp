@@ -0,0 +1,176 @@
+#ifndef STOPPING_HPP
+#define STOPPING_HPP
+
+#include "detail/state.hpp"
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cmath> // `std::sqrt`, `std::abs`
+#include <algorithm> // `std::max`
+
+// Critère d'arrêt à précision donnée, pour `replicas` suites indépendantes d'un même noyau de
+// calcul exécutées ensemble, cf `replicated_kernel::compute` dans `src/parallel.hpp`.
+//
+// Les termes successifs d'une suite d'approximation stochastique sont très corrélés, et une
+// trajectoire qui dérive encore lentement peut sembler stable sur n'importe quelle fenêtre: la
+// dispersion de la trajectoire elle-même ne dit rien de l'erreur. On compare donc des suites
+// indépendantes. Aux pas `first`, `2 first`, `4 first`, ..., chaque réplica attend les autres,
+// puis l'on calcule pour $\xi$ et pour $C$:
+// * la demi-largeur $h$ de l'intervalle de confiance à 95% de la moyenne des réplicas (loi de
+//   Student à `replicas - 1` degrés de liberté);
+// * la dérive $d$, écart entre cette moyenne et celle du point de contrôle précédent,
+//   c'est-à-dire à mi-parcours: une phase transitoire commune à tous les réplicas n'élargit pas
+//   l'intervalle, mais déplace la moyenne d'un point de contrôle à l'autre. Si l'écart à la
+//   limite décroît au moins comme $n^{-1/2}$, ce qu'il reste à parcourir est au plus
+//   $b = \frac{d}{\sqrt{2} - 1}$ (somme des dérives des doublements suivants).
+// On s'arrête dès que $h + b$ est inférieur à `tolerance` pour $\xi$ et pour $C$. Une suite
+// qui dérive comme $\log n$ (pas $\frac{1}{n}$ trop petit pour la pente de la fonction de
+// répartition, par exemple) garde une dérive constante et ne s'arrête jamais.
+class tolerance {
+    private:
+        double tol;
+        int replicas, first;
+
+        // Points de rendez-vous des réplicas, cf `arrive` et `leave`.
+        std::mutex mutex;
+        std::condition_variable released;
+        int active, arrived = 0;
+        long long generation = 0;
+        bool stop = false;
+
+        // Dernière valeur reçue de chaque réplica, et moyennes du point de contrôle précédent.
+        std::vector<detail::state<2>> values;
+        detail::state<2> previous {};
+        bool has_previous = false;
+        int checkpoint = 0, stopped_at = -1;
+        double xi_bound = -1, C_bound = -1;
+
+        // Quantile à 97.5% de la loi de Student à `dof` degrés de liberté.
+        static auto student(int dof) -> double {
+            static const double quantiles[] = {
+                12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+            };
+            return dof <= 30 ? quantiles[dof - 1] : 1.96;
+        }
+
+        // Appelé, le verrou pris, quand tous les réplicas encore actifs sont au rendez-vous.
+        void decide() {
+            auto R = static_cast<double>(values.size());
+            detail::state<2> mean {}, var {};
+            for (const auto & v : values)
+                mean += v;
+            mean /= R;
+            for (const auto & v : values)
+                for (std::size_t i = 0; i < 2; ++i)
+                    var[i] += (v[i] - mean[i]) * (v[i] - mean[i]);
+            var /= R - 1;
+
+            if (has_previous) {
+                auto t = student(static_cast<int>(values.size()) - 1);
+                auto remaining = 1 / (std::sqrt(2.) - 1);
+                xi_bound = t * std::sqrt(var[0] / R) + remaining * std::abs(mean[0] - previous[0]);
+                C_bound = t * std::sqrt(var[1] / R) + remaining * std::abs(mean[1] - previous[1]);
+                if (xi_bound <= tol && C_bound <= tol) {
+                    stop = true;
+                    stopped_at = checkpoint;
+                }
+            }
+            previous = mean;
+            has_previous = true;
+        }
+
+        // Rendez-vous du réplica `r` au pas `n`; renvoie `false` s'il faut s'arrêter.
+        auto arrive(int r, int n, const detail::state<2> & value) -> bool {
+            std::unique_lock<std::mutex> lock { mutex };
+            values[r] = value;
+            checkpoint = n;
+            if (++arrived == active) {
+                decide();
+                arrived = 0;
+                ++generation;
+                released.notify_all();
+            } else {
+                auto g = generation;
+                released.wait(lock, [&]() { return generation != g; });
+            }
+            return !stop;
+        }
+
+    public:
+        // Observateur du réplica `r`, à passer à la méthode `compute` du noyau; les termes
+        // $(\xi_n, \theta_n, \mu_n)$ de la phase 1 de `IS_kernel` ne sont pas pris en compte.
+        class observer {
+            private:
+                tolerance * rule;
+                int r, next;
+
+            public:
+                observer(tolerance * rule, int r) : rule { rule }, r { r }, next { rule->first }
+                {
+                }
+
+                auto operator ()(int, const detail::state<3> &) -> bool {
+                    return true;
+                }
+
+                auto operator ()(int n, const detail::state<2> & state) -> bool {
+                    if (n + 1 < next)
+                        return true;
+                    next *= 2;
+                    return rule->arrive(r, n + 1, state);
+                }
+        };
+
+        // Paramètres du constructeur:
+        // * `tolerance`: erreur visée
+        // * `replicas`: nombre de réplicas, au moins 2
+        // * `first`: pas du premier point de contrôle
+        tolerance(double tolerance, int replicas, int first = 1000) :
+            tol { tolerance }, replicas { std::max(replicas, 2) }, first { std::max(first, 1) },
+            active { this->replicas }, values(this->replicas)
+        {
+        }
+
+        tolerance(const tolerance &) = delete;
+        auto operator =(const tolerance &) -> tolerance & = delete;
+
+        auto replica_count() const -> int {
+            return replicas;
+        }
+
+        auto replica(int r) -> observer {
+            return observer { this, r };
+        }
+
+        // À appeler quand le réplica `r` a terminé, avec son résultat: les autres ne
+        // l'attendent plus, et sa dernière valeur compte pour les points de contrôle suivants.
+        void leave(int r, double xi, double C) {
+            std::lock_guard<std::mutex> lock { mutex };
+            values[r] = detail::make_state(xi, C);
+            --active;
+            if (arrived > 0 && arrived == active) {
+                decide();
+                arrived = 0;
+                ++generation;
+                released.notify_all();
+            }
+        }
+
+        // Nombre de pas de chaque réplica si le critère a été satisfait, -1 sinon.
+        auto iterations() const -> int {
+            return stopped_at;
+        }
+
+        // Dernières bornes $h + b$ calculées pour $\xi$ et $C$ (-1 si aucune ne l'a été).
+        auto xi_error() const -> double {
+            return xi_bound;
+        }
+
+        auto C_error() const -> double {
+            return C_bound;
+        }
+};
+
+#endif
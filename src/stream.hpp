@@ -0,0 +1,157 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <cstddef> // `std::size_t`
+#include <cstring> // `std::strerror`
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <fcntl.h> // `open`
+#include <unistd.h> // `read`, `close`
+#include <sys/mman.h> // `mmap`, `munmap`, `madvise`
+#include <sys/stat.h> // `fstat`
+
+// Sources de pertes précalculées pour `approx_kernel::consume` (cf `src/estimate.hpp`), par
+// exemple produites par un moteur de réévaluation externe. Les pertes sont des `double` au
+// format binaire natif de la machine, les unes à la suite des autres. Une source fournit les
+// pertes par blocs via `next_chunk(data)`, qui fait pointer `data` sur le bloc suivant et en
+// renvoie la taille (0 à la fin de la source); le bloc reste valable jusqu'à l'appel suivant.
+
+// Taille par défaut des blocs: $2^{20}$ pertes, soit 8 Mo.
+constexpr std::size_t loss_chunk = 1 << 20;
+
+// Fichier projeté en mémoire: les blocs pointent directement dans la projection, sans copie.
+// On annonce au noyau une lecture séquentielle et on demande la lecture anticipée du bloc
+// suivant, pour lire au débit du disque; les pages des blocs déjà lus sont rendues au fur et à
+// mesure, si bien que le fichier peut être bien plus gros que la mémoire disponible.
+class mapped_losses {
+    private:
+        int fd = -1;
+        void * memory = nullptr;
+        std::size_t bytes = 0, count = 0, chunk;
+        std::size_t position = 0; // début du prochain bloc
+        std::size_t released = 0; // début des pages pas encore rendues
+
+        static auto error(const std::string & what, const std::string & path) -> std::string {
+            return what + " `" + path + "`: " + std::strerror(errno);
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `path`: fichier à lire, dont la taille doit être un multiple de `sizeof(double)`
+        // * `chunk`: taille des blocs, ramenée à un multiple de la taille des pages
+        explicit mapped_losses(const std::string & path, std::size_t chunk = loss_chunk) :
+            chunk { chunk }
+        {
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw error("cannot open", path);
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                ::close(fd);
+                throw error("cannot stat", path);
+            }
+            bytes = static_cast<std::size_t>(info.st_size);
+            if (bytes % sizeof(double) != 0) {
+                ::close(fd);
+                throw "size of `" + path + "` is not a multiple of "
+                    + std::to_string(sizeof(double));
+            }
+            count = bytes / sizeof(double);
+            if (bytes == 0)
+                return;
+
+            memory = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+            if (memory == MAP_FAILED) {
+                ::close(fd);
+                throw error("cannot map", path);
+            }
+            ::madvise(memory, bytes, MADV_SEQUENTIAL);
+
+            auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / sizeof(double);
+            this->chunk = (chunk + page - 1) / page * page;
+        }
+
+        mapped_losses(const mapped_losses &) = delete;
+        auto operator =(const mapped_losses &) -> mapped_losses & = delete;
+
+        ~mapped_losses() {
+            if (memory != nullptr)
+                ::munmap(memory, bytes);
+            ::close(fd);
+        }
+
+        // Nombre total de pertes du fichier.
+        auto size() const -> std::size_t {
+            return count;
+        }
+
+        auto next_chunk(const double * & data) -> std::size_t {
+            auto losses = static_cast<const double *>(memory);
+            // Le bloc précédent a été entièrement lu; il commence sur une page, puisque `chunk`
+            // est un multiple de la taille des pages.
+            if (position > released) {
+                ::madvise(
+                    const_cast<double *>(losses + released),
+                    (position - released) * sizeof(double),
+                    MADV_DONTNEED
+                );
+                released = position;
+            }
+            if (position == count)
+                return 0;
+
+            auto size = count - position < chunk ? count - position : chunk;
+            data = losses + position;
+            position += size;
+            if (position < count) {
+                auto ahead = count - position < chunk ? count - position : chunk;
+                ::madvise(
+                    const_cast<double *>(losses + position),
+                    ahead * sizeof(double),
+                    MADV_WILLNEED
+                );
+            }
+            return size;
+        }
+};
+
+// Descripteur de fichier lu séquentiellement (typiquement l'entrée standard, ou un tube): les
+// pertes sont lues par blocs dans un tampon, par de grands appels à `read`.
+class fd_losses {
+    private:
+        int fd;
+        std::vector<double> buffer;
+
+    public:
+        // Paramètres du constructeur:
+        // * `fd`: descripteur à lire (non fermé par la source)
+        // * `chunk`: taille des blocs
+        explicit fd_losses(int fd = 0, std::size_t chunk = loss_chunk) : fd { fd }, buffer(chunk)
+        {
+        }
+
+        auto next_chunk(const double * & data) -> std::size_t {
+            // On remplit tout le tampon, sauf à la fin du flux: une perte incomplète ne peut
+            // donc se trouver qu'à la toute fin.
+            auto bytes = buffer.size() * sizeof(double);
+            auto start = reinterpret_cast<char *>(buffer.data());
+            std::size_t filled = 0;
+            while (filled < bytes) {
+                auto r = ::read(fd, start + filled, bytes - filled);
+                if (r < 0 && errno == EINTR)
+                    continue;
+                if (r < 0)
+                    throw std::string { "cannot read losses: " } + std::strerror(errno);
+                if (r == 0)
+                    break;
+                filled += static_cast<std::size_t>(r);
+            }
+            if (filled % sizeof(double) != 0)
+                throw std::string { "truncated loss stream" };
+            data = buffer.data();
+            return filled / sizeof(double);
+        }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef SURROGATE_HPP
+#define SURROGATE_HPP
+
+#include "detail/quantile.hpp"
+#include <random>
+#include <vector>
+#include <cmath> // `std::abs`, `std::log`
+#include <algorithm> // `std::max`
+#include <limits> // `std::numeric_limits`
+#include <cstddef> // `std::size_t`
+
+// Approximation tabulée d'une fonction de perte $\phi$ coûteuse à évaluer, pour un modèle à un
+// facteur (comme `short_put`): $\phi$ n'est évaluée qu'une fois par noeud d'une grille, puis
+// chaque appel interpole linéairement entre deux noeuds. On s'en sert comme `phi` dans les
+// noyaux de `src/estimate.hpp`, à la place de la fonction exacte.
+//
+// La grille est uniforme sur un intervalle `[lo, hi]` (typiquement entre deux quantiles
+// extrêmes de la loi de $X$, cf `tabulate`), ce qui permet de trouver la cellule d'un point par
+// une simple multiplication. Pour chaque cellule, on mesure l'erreur d'interpolation en 7 points
+// intérieurs; les cellules où elle dépasse la tolérance (autour d'un point anguleux de $\phi$,
+// comme le strike d'une option) sont marquées, ainsi que leurs deux voisines, et $\phi$ y est
+// évaluée exactement. On double le nombre de cellules tant que plus d'un centième d'entre elles
+// sont marquées, dans la limite de `max_cells`. En dehors de `[lo, hi]`, $\phi$ est aussi
+// évaluée exactement.
+template<class Phi>
+class tabulated {
+    private:
+        // Valeur au noeud gauche, et accroissement sur la cellule (NaN si la cellule est
+        // évaluée exactement).
+        struct cell {
+            double value, increment;
+        };
+
+        const Phi & phi;
+        double lo, hi, inv_h;
+        std::vector<cell> table;
+        int exact = 0;
+        double error = 0;
+
+        void build(int cells, double tolerance) {
+            auto h = (hi - lo) / cells;
+            inv_h = 1 / h;
+            std::vector<double> nodes(cells + 1);
+            for (int i = 0; i <= cells; ++i)
+                nodes[i] = phi(lo + i * h);
+
+            table.assign(cells, cell { });
+            std::vector<double> errors(cells);
+            std::vector<char> marked(cells);
+            for (int i = 0; i < cells; ++i) {
+                auto increment = nodes[i + 1] - nodes[i];
+                double worst = 0;
+                for (int j = 1; j < 8; ++j) {
+                    auto t = j / 8.;
+                    auto approx = nodes[i] + increment * t;
+                    worst = std::max(worst, std::abs(phi(lo + (i + t) * h) - approx));
+                }
+                table[i] = cell { nodes[i], increment };
+                errors[i] = worst;
+                marked[i] = !(worst <= tolerance);
+            }
+
+            exact = 0;
+            error = 0;
+            for (int i = 0; i < cells; ++i) {
+                auto near = marked[i] || (i > 0 && marked[i - 1])
+                    || (i + 1 < cells && marked[i + 1]);
+                if (near) {
+                    table[i].increment = std::numeric_limits<double>::quiet_NaN();
+                    ++exact;
+                } else {
+                    error = std::max(error, errors[i]);
+                }
+            }
+        }
+
+    public:
+        // Paramètres du constructeur:
+        // * `phi`: fonction de perte `double -> double` à approcher
+        // * `lo`, `hi`: intervalle tabulé
+        // * `tolerance`: erreur d'interpolation maximale tolérée
+        // * `max_cells`: nombre maximal de cellules
+        tabulated(
+            const Phi & phi,
+            double lo,
+            double hi,
+            double tolerance,
+            int max_cells = 1 << 16
+        ) : phi(phi), lo { lo }, hi { hi }
+        {
+            for (int cells = 64; ; cells *= 2) {
+                build(cells, tolerance);
+                if (exact <= std::max(3, cells / 100) || 2 * cells > max_cells)
+                    break;
+            }
+        }
+
+        auto operator ()(double x) const -> double {
+            auto t = (x - lo) * inv_h;
+            // La comparaison est fausse pour `t` NaN, qui est donc aussi évalué exactement.
+            if (!(t >= 0 && t < table.size()))
+                return phi(x);
+            auto i = static_cast<std::size_t>(t);
+            const auto & c = table[i];
+            if (c.increment != c.increment)
+                return phi(x);
+            return c.value + c.increment * (t - i);
+        }
+
+        // Nombre de cellules de la grille.
+        auto cells() const -> int {
+            return static_cast<int>(table.size());
+        }
+
+        // Nombre de cellules évaluées exactement.
+        auto exact_cells() const -> int {
+            return exact;
+        }
+
+        // Plus grande erreur d'interpolation mesurée sur les cellules interpolées.
+        auto max_error() const -> double {
+            return error;
+        }
+};
+
+// Fonctions utilitaires pour inférer le paramètre template de `tabulated`, cf
+// `src/estimate.hpp/stochastic_gradient`. Sans intervalle explicite, on tabule entre les
+// quantiles d'ordre `p` et `1 - p` de la loi `d`.
+template<class Phi>
+auto tabulate(
+    const Phi & phi,
+    double lo,
+    double hi,
+    double tolerance
+) -> tabulated<Phi>
+{
+    return tabulated<Phi> { phi, lo, hi, tolerance };
+}
+
+template<class Phi>
+auto tabulate(
+    const Phi & phi,
+    const std::normal_distribution<> & d,
+    double tolerance,
+    double p = 1e-7
+) -> tabulated<Phi>
+{
+    auto width = -detail::normal_quantile(p) * d.stddev();
+    return tabulated<Phi> { phi, d.mean() - width, d.mean() + width, tolerance };
+}
+
+template<class Phi>
+auto tabulate(
+    const Phi & phi,
+    const std::exponential_distribution<> & d,
+    double tolerance,
+    double p = 1e-7
+) -> tabulated<Phi>
+{
+    return tabulated<Phi> { phi, 0., -std::log(p) / d.lambda(), tolerance };
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SWITCHING_HPP
+#define SWITCHING_HPP
+
+// Passage de la phase 1 à la phase 2 de `importance_sampling`, cf `src/estimate.hpp`.
+// * `fixed`: la phase 1 fait `iterations / 100` pas, le niveau de confiance adaptatif passant
+//   de 0.5 à 0.8 puis à `alpha` à chaque tiers.
+// * `adaptive`: on surveille la phase 1 (cf `src/detail/importance_sampling.hpp/phase1_monitor`)
+//   et l'on passe au niveau suivant, puis à la phase 2, dès que $\theta_n$ et $\mu_n$ se sont
+//   stabilisés et que l'on a observé assez de réalisations dans la queue. Les pas que la
+//   phase 1 n'a pas utilisés sont donnés à la phase 2.
+enum class switching {
+    fixed,
+    adaptive,
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef VARIANCE_REDUCTION_HPP
+#define VARIANCE_REDUCTION_HPP
+
+// Options de réduction de variance de `stochastic_gradient`, cf `src/estimate.hpp`.
+
+// Variables antithétiques: chaque pas utilise un tirage $X$ et son symétrique $X'$ (de même loi,
+// cf `src/detail/variance_reduction.hpp`), et la moyenne des deux gradients. Un pas coûte donc
+// deux évaluations de $\phi$, et l'on fait deux fois moins de pas pour le même budget.
+enum class antithetic {
+    yes,
+    no,
+};
+
+// Variable de contrôle: une fonction $h$ du tirage $X$ dont l'espérance `mean` est connue
+// (par exemple le paiement d'un put, dont l'espérance est donnée par la formule de
+// Black-Scholes). À chaque pas, on retranche $\beta (h(X) - mean)$ aux termes $H1$ et $v$ du
+// gradient, le coefficient $\beta$ étant estimé au fil de l'eau par régression sur les pas
+// précédents.
+template<class H>
+struct control_variate {
+    const H & h;
+    double mean;
+};
+
+// Fonction utilitaire pour inférer le paramètre template de `control_variate`.
+template<class H>
+auto control(const H & h, double mean) -> control_variate<H> {
+    return control_variate<H> { h, mean };
+}
+
+#endif
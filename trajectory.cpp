@@ -0,0 +1,44 @@
+#include "src/record.hpp"
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <cstring> // `std::memcmp`
+
+// Convertit un fichier de trajectoire écrit par `trajectory_recorder` (cf `src/record.hpp`) en
+// CSV sur la sortie standard, cf `README.txt`.
+auto main(int argc, char ** argv) -> int {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in { argv[1], std::ios::binary };
+    trajectory_header header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof header)
+        || std::memcmp(header.magic, "MCTRAJ1", 8) != 0) {
+        std::cerr << "not a trajectory file: " << argv[1] << std::endl;
+        return 1;
+    }
+    if (header.version != trajectory_version || header.record_size != sizeof(trajectory_record)) {
+        std::cerr << "unsupported trajectory version: " << header.version << std::endl;
+        return 1;
+    }
+
+    std::cout.precision(std::numeric_limits<double>::max_digits10);
+    std::cout << "phase,n,v0,v1,v2" << std::endl;
+    trajectory_record record;
+    for (std::uint64_t i = 0; i < header.count; ++i) {
+        if (!in.read(reinterpret_cast<char *>(&record), sizeof record)) {
+            std::cerr << "truncated trajectory file: " << argv[1] << std::endl;
+            return 1;
+        }
+        std::cout << record.phase << "," << record.n;
+        for (std::uint32_t k = 0; k < 3; ++k) {
+            std::cout << ",";
+            if (k < record.size)
+                std::cout << record.values[k];
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "src/estimate.hpp"
+#include "src/random.hpp"
+#include "src/detail/thread_pool.hpp"
+#include <random>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <utility> // `std::pair`
+#include <algorithm> // `std::find_if`
+
+// Exécute une liste de calculs de V@R et CV@R lue dans un fichier, sur un groupe de threads,
+// cf `README.txt`.
+
+enum class job_method {
+    stochastic_gradient,
+    importance_sampling,
+};
+
+// Un calcul, c'est-à-dire une ligne du fichier.
+struct job {
+    double alpha;
+    int N;
+    job_method method;
+    averaging avg;
+    double exponent, offset;
+    // Put vendu, comme dans `short_put.cpp` mais avec des paramètres quelconques, cf
+    // `src/losses.hpp`.
+    losses::black_scholes model;
+    double strike, premium;
+};
+
+struct batch_args {
+    std::string path; // "-" pour l'entrée standard
+    int threads = detail::default_threads();
+    std::uint64_t seed = 0;
+    bool shared = false;
+};
+
+auto parse_batch_args(int argc, char ** argv) -> batch_args {
+    batch_args args;
+    std::random_device rd;
+    args.seed = static_cast<std::uint64_t>(rd()) << 32 | rd();
+
+    for (int i = 1; i < argc; ++i) {
+        auto option = std::string { argv[i] };
+        if (option == "--threads") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--threads`" };
+            auto value = std::string { argv[i] };
+            try { args.threads = std::stoi(value); } catch(...) { args.threads = -1; }
+            if (args.threads <= 0)
+                throw "bad threads value: " + value;
+        } else if (option == "--seed") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--seed`" };
+            auto value = std::string { argv[i] };
+            try { args.seed = std::stoull(value); } catch(...) { throw "bad seed value: " + value; }
+        } else if (option == "--shared") {
+            args.shared = true;
+        } else if (args.path.empty()) {
+            args.path = option;
+        } else {
+            throw "unknown option: " + option;
+        }
+    }
+    if (args.path.empty())
+        throw std::string { "missing job file" };
+    return args;
+}
+
+// Lit un fichier CSV de colonnes
+// `alpha,N,method,averaging,exponent,offset,strike,spot,vol,rate,premium`. Les lignes vides,
+// les lignes commençant par `#` et une éventuelle ligne d'en-tête sont ignorées.
+auto parse_jobs(std::istream & in) -> std::vector<job> {
+    std::vector<job> jobs;
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.empty() || line[0] == '#' || line.compare(0, 5, "alpha") == 0)
+            continue;
+
+        std::vector<std::string> fields;
+        std::string::size_type start = 0;
+        while (true) {
+            auto end = line.find(',', start);
+            fields.push_back(line.substr(start, end - start));
+            if (end == std::string::npos)
+                break;
+            start = end + 1;
+        }
+        auto where = "line " + std::to_string(number) + ": ";
+        if (fields.size() != 11)
+            throw where + "expected 11 fields";
+
+        auto number_field = [&](std::size_t k) -> double {
+            try { return std::stod(fields[k]); }
+            catch(...) { throw where + "bad value: " + fields[k]; }
+        };
+
+        job j;
+        j.alpha = number_field(0);
+        if (j.alpha <= 0 || j.alpha >= 1)
+            throw where + "bad alpha value: " + fields[0];
+        try { j.N = std::stoi(fields[1]); } catch(...) { j.N = -1; }
+        if (j.N <= 100)
+            throw where + "bad N value: " + fields[1];
+        if (fields[2] == "stochastic-gradient")
+            j.method = job_method::stochastic_gradient;
+        else if (fields[2] == "importance-sampling")
+            j.method = job_method::importance_sampling;
+        else
+            throw where + "bad method name: " + fields[2];
+        if (fields[3] == "yes")
+            j.avg = averaging::yes;
+        else if (fields[3] == "no")
+            j.avg = averaging::no;
+        else
+            throw where + "bad averaging parameter: " + fields[3];
+        j.exponent = number_field(4);
+        if (j.exponent <= 0 || j.exponent > 1)
+            throw where + "bad exponent value: " + fields[4];
+        j.offset = number_field(5);
+        if (j.offset < 0)
+            throw where + "bad offset value: " + fields[5];
+        j.strike = number_field(6);
+        j.model = losses::black_scholes { number_field(7), number_field(8), number_field(9), 1 };
+        j.premium = number_field(10);
+        if (j.model.spot <= 0 || j.model.vol <= 0)
+            throw where + "spot and vol must be positive";
+        jobs.push_back(j);
+    }
+    return jobs;
+}
+
+// Exécute un calcul avec la suite de pas choisie par `steps::dispatch`.
+class job_runner {
+    private:
+        const job & j;
+        philox4x32 & g;
+        std::pair<double, double> & result;
+
+    public:
+        job_runner(const job & j, philox4x32 & g, std::pair<double, double> & result) :
+            j(j), g(g), result(result)
+        {
+        }
+
+        template<class Gamma>
+        void operator ()(const Gamma & gamma) const {
+            auto d = std::normal_distribution<> { 0., 1. };
+            auto loss = losses::european_put { j.model, j.strike, -1, j.premium };
+            if (j.method == job_method::stochastic_gradient)
+                result = stochastic_gradient(j.alpha, j.N, loss, gamma, j.avg).compute(d, g);
+            else
+                result = importance_sampling(j.alpha, 1., j.N, loss, gamma, j.avg).compute(d, g);
+        }
+};
+
+// Exécute avec `stochastic_gradient_portfolios` un groupe de calculs par gradient stochastique
+// qui ne diffèrent que par leur put vendu: les tirages de $X$ sont partagés entre les puts.
+class group_runner {
+    private:
+        const std::vector<job> & jobs;
+        const std::vector<int> & group;
+        philox4x32 & g;
+        std::vector<std::pair<double, double>> & results;
+
+    public:
+        group_runner(
+            const std::vector<job> & jobs,
+            const std::vector<int> & group,
+            philox4x32 & g,
+            std::vector<std::pair<double, double>> & results
+        ) : jobs(jobs), group(group), g(g), results(results)
+        {
+        }
+
+        template<class Gamma>
+        void operator ()(const Gamma & gamma) const {
+            auto d = std::normal_distribution<> { 0., 1. };
+            std::vector<losses::european_put> puts;
+            for (auto i : group) {
+                const auto & j = jobs[i];
+                puts.push_back(losses::european_put { j.model, j.strike, -1, j.premium });
+            }
+            const auto & first = jobs[group[0]];
+            results = stochastic_gradient_portfolios(first.alpha, first.N, puts, gamma, first.avg)
+                .compute(d, g);
+        }
+};
+
+// Avec `--shared`, regroupe les calculs par gradient stochastique de mêmes `alpha`, `N`,
+// `averaging`, `exponent` et `offset`, dans l'ordre de leur première apparition. Les autres
+// calculs forment chacun leur propre groupe.
+auto group_jobs(const std::vector<job> & jobs, bool shared) -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> groups;
+    for (int i = 0; i < static_cast<int>(jobs.size()); ++i) {
+        const auto & j = jobs[i];
+        auto same = [&](const std::vector<int> & group) {
+            const auto & k = jobs[group[0]];
+            return k.method == job_method::stochastic_gradient && k.alpha == j.alpha
+                && k.N == j.N && k.avg == j.avg && k.exponent == j.exponent
+                && k.offset == j.offset;
+        };
+        auto it = groups.end();
+        if (shared && j.method == job_method::stochastic_gradient)
+            it = std::find_if(groups.begin(), groups.end(), same);
+        if (it == groups.end())
+            groups.push_back(std::vector<int> { i });
+        else
+            it->push_back(i);
+    }
+    return groups;
+}
+
+// Écrit les résultats dans l'ordre des calculs, au fur et à mesure: le résultat du calcul `i`
+// est écrit dès que ceux des calculs `0, ..., i - 1` l'ont été.
+class ordered_output {
+    private:
+        std::mutex mutex;
+        std::vector<std::pair<double, double>> results;
+        std::vector<char> done;
+        std::size_t next = 0;
+
+    public:
+        explicit ordered_output(std::size_t count) : results(count), done(count)
+        {
+        }
+
+        void publish(std::size_t i, std::pair<double, double> result) {
+            std::lock_guard<std::mutex> lock { mutex };
+            results[i] = result;
+            done[i] = 1;
+            for (; next < done.size() && done[next]; ++next)
+                std::cout << next << "," << results[next].first << "," << results[next].second
+                          << "\n";
+            std::cout.flush();
+        }
+};
+
+auto main(int argc, char ** argv) -> int {
+    batch_args args;
+    std::vector<job> jobs;
+    try {
+        args = parse_batch_args(argc, argv);
+        if (args.path == "-") {
+            jobs = parse_jobs(std::cin);
+        } else {
+            std::ifstream in { args.path };
+            if (!in)
+                throw "cannot open `" + args.path + "`";
+            jobs = parse_jobs(in);
+        }
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
+    }
+
+    // Les groupes de calculs sont distribués dynamiquement entre les threads (cf
+    // `detail::parallel_for`). Un groupe utilise le flux du générateur dont le numéro est celui
+    // de son premier calcul: les résultats ne dépendent pas du nombre de threads.
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    std::cout << "job,xi,C" << std::endl;
+    ordered_output output { jobs.size() };
+    auto groups = group_jobs(jobs, args.shared);
+    detail::parallel_for(static_cast<int>(groups.size()), args.threads, [&](int k) {
+        const auto & group = groups[k];
+        const auto & j = jobs[group[0]];
+        auto g = philox4x32 { args.seed, static_cast<std::uint64_t>(group[0]) };
+        if (group.size() == 1) {
+            std::pair<double, double> result;
+            steps::dispatch(j.exponent, j.offset, job_runner { j, g, result });
+            output.publish(group[0], result);
+            return;
+        }
+        std::vector<std::pair<double, double>> results;
+        steps::dispatch(j.exponent, j.offset, group_runner { jobs, group, g, results });
+        for (std::size_t p = 0; p < group.size(); ++p)
+            output.publish(group[p], results[p]);
+    });
+
+    auto seconds = std::chrono::duration<double> { clock::now() - start }.count();
+    std::cerr << jobs.size() << " jobs in " << seconds << " s (" << jobs.size() / seconds
+              << " jobs/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "src/estimate.hpp"
+#include "src/random.hpp"
+#include "src/losses.hpp"
+#include "command_line.hpp"
+#include <random>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+// Calcul de la V@R et CV@R décrit par un fichier de configuration, cf `README.txt`: la loi de
+// $X$, la fonction de perte et les options de `command_line.hpp` sont lues à l'exécution. Les
+// combinaisons possibles de loi et de fonction de perte sont instanciées à la compilation, et
+// le choix est fait une seule fois, dans `run_engine`; la boucle de calcul est ensuite
+// exactement celle de `short_put` ou `exponential_distribution`.
+
+enum class engine_distribution {
+    normal,
+    exponential,
+};
+
+// Description lue dans le fichier de configuration.
+struct engine_config {
+    engine_distribution distribution = engine_distribution::normal;
+    double mean = 0., stddev = 1., lambda = 1.;
+    losses::black_scholes model { 100, 0.2, 0.05, 1 };
+    std::vector<losses::position> positions; // perte $\phi(x) = x$ si vide
+    std::vector<std::string> options; // options de la ligne de commande, cf `parse_command_line`
+    std::vector<std::string> parameters { "", "" }; // `alpha` et `N`, vides s'ils sont absents
+};
+
+// Lit un fichier de lignes `<clé> <valeurs>`, séparées par des espaces. Les lignes vides et les
+// lignes commençant par `#` sont ignorées. Les clés propres au moteur sont `distribution`,
+// `model` et `position`; `alpha` et `N` donnent les deux paramètres positionnels (remplacés par
+// ceux de la ligne de commande, cf `main`), et toute autre clé `k` devient l'option `--k` de la
+// ligne de commande.
+auto parse_engine_config(std::istream & in) -> engine_config {
+    engine_config config;
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        std::istringstream words { line };
+        std::string key;
+        if (!(words >> key) || key[0] == '#')
+            continue;
+        auto where = "line " + std::to_string(number) + ": ";
+
+        std::vector<std::string> values;
+        std::string value;
+        while (words >> value)
+            values.push_back(value);
+        auto number_value = [&](std::size_t k) -> double {
+            if (k >= values.size())
+                throw where + "missing value for `" + key + "`";
+            try { return std::stod(values[k]); }
+            catch(...) { throw where + "bad value: " + values[k]; }
+        };
+
+        if (key == "distribution") {
+            if (values.empty())
+                throw where + "missing distribution name";
+            if (values[0] == "normal") {
+                config.distribution = engine_distribution::normal;
+                config.mean = number_value(1);
+                config.stddev = number_value(2);
+                if (config.stddev <= 0)
+                    throw where + "stddev must be positive";
+            } else if (values[0] == "exponential") {
+                config.distribution = engine_distribution::exponential;
+                config.lambda = number_value(1);
+                if (config.lambda <= 0)
+                    throw where + "lambda must be positive";
+            } else {
+                throw where + "bad distribution name: " + values[0];
+            }
+        } else if (key == "model") {
+            config.model = losses::black_scholes {
+                number_value(0),
+                number_value(1),
+                number_value(2),
+                number_value(3)
+            };
+            if (config.model.spot <= 0 || config.model.vol <= 0 || config.model.maturity <= 0)
+                throw where + "spot, vol and maturity must be positive";
+        } else if (key == "position") {
+            if (values.empty())
+                throw where + "missing position kind";
+            losses::position p;
+            if (values[0] == "put")
+                p.kind = losses::position_kind::put;
+            else if (values[0] == "call")
+                p.kind = losses::position_kind::call;
+            else if (values[0] == "forward")
+                p.kind = losses::position_kind::forward;
+            else if (values[0] == "linear")
+                p.kind = losses::position_kind::linear;
+            else
+                throw where + "bad position kind: " + values[0];
+            p.strike = number_value(1);
+            p.quantity = number_value(2);
+            p.premium = number_value(3);
+            config.positions.push_back(p);
+        } else if (key == "alpha" || key == "N") {
+            if (values.size() != 1)
+                throw where + "`" + key + "` needs a single value";
+            config.parameters[key == "alpha" ? 0 : 1] = values[0];
+        } else {
+            config.options.push_back("--" + key);
+            config.options.insert(config.options.end(), values.begin(), values.end());
+        }
+    }
+    return config;
+}
+
+// Choisit, une fois pour toutes, la fonction de perte et la loi de `config`, puis exécute les
+// calculs demandés par `args` avec `run_command_line`. Un portefeuille réduit à un put est
+// évalué par `losses::european_put`, comme dans `short_put`.
+void run_engine(const engine_config & config, const command_line_args & args) {
+    auto g = philox4x32 { args.seed };
+    auto none = [](double) { };
+
+    if (config.distribution == engine_distribution::exponential) {
+        if (!config.positions.empty())
+            throw std::string { "positions need the normal distribution" };
+        auto d = std::exponential_distribution<> { config.lambda };
+        auto phi = identity;
+        run_command_line(args, phi, d, g, none);
+        return;
+    }
+
+    auto d = std::normal_distribution<> { config.mean, config.stddev };
+    if (config.positions.empty()) {
+        auto phi = identity;
+        run_command_line(args, phi, d, g, none);
+    } else if (config.positions.size() == 1
+               && config.positions[0].kind == losses::position_kind::put) {
+        const auto & p = config.positions[0];
+        auto phi = losses::european_put { config.model, p.strike, p.quantity, p.premium };
+        run_command_line(args, phi, d, g, none);
+    } else {
+        auto phi = losses::portfolio { config.model, config.positions };
+        run_command_line(args, phi, d, g, none);
+    }
+}
+
+auto main(int argc, char ** argv) -> int {
+    try {
+        if (argc < 2)
+            throw std::string { "missing config file" };
+        auto path = std::string { argv[1] };
+        engine_config config;
+        if (path == "-") {
+            config = parse_engine_config(std::cin);
+        } else {
+            std::ifstream in { path };
+            if (!in)
+                throw "cannot open `" + path + "`";
+            config = parse_engine_config(in);
+        }
+
+        // Les options de la ligne de commande qui suivent le fichier s'ajoutent à celles du
+        // fichier, et l'emportent sur elles; de même, `alpha` et `N` donnés sur la ligne de
+        // commande remplacent ceux du fichier.
+        std::vector<std::string> words { argv[0] };
+        words.insert(words.end(), config.options.begin(), config.options.end());
+        words.insert(words.end(), argv + 2, argv + argc);
+        std::vector<char *> pointers;
+        for (auto & w : words)
+            pointers.push_back(&w[0]);
+        auto args = parse_command_line(static_cast<int>(pointers.size()), pointers.data(), config.parameters);
+
+        run_engine(config, args);
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
+    } catch (const char * s) {
+        std::cerr << s << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "src/estimate.hpp"
+#include "src/stream.hpp"
+#include "src/losses.hpp"
+#include "src/random.hpp"
+#include "src/detail/state.hpp"
+#include <string>
+#include <random>
+#include <cstdio> // `std::tmpfile`
+#include <iostream>
+#include <utility> // `std::pair`
+
+// Calcul de la V@R et de la CV@R à partir de pertes précalculées, lues dans un fichier ou sur
+// l'entrée standard, cf `README.txt`.
+
+struct stream_args {
+    double alpha = -1.;
+    std::string path; // "-" pour l'entrée standard
+    averaging avg = averaging::no;
+    double exponent = 1.;
+    double offset = 0.;
+    long long every = 0; // intervalle entre deux résultats intermédiaires, 0 pour aucun
+};
+
+auto parse_stream_args(int argc, char ** argv) -> stream_args {
+    stream_args args;
+    for (int i = 1; i < argc; ++i) {
+        auto option = std::string { argv[i] };
+        if (option == "--averaging") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--averaging`" };
+            auto value = std::string { argv[i] };
+            if (value == "yes")
+                args.avg = averaging::yes;
+            else if (value == "no")
+                args.avg = averaging::no;
+            else
+                throw "bad averaging parameter: " + value;
+        } else if (option == "--step") {
+            ++i;
+            if (i + 1 >= argc)
+                throw std::string { "missing argument for `--step`" };
+            auto value = std::string { argv[i] };
+            try { args.exponent = std::stod(value); } catch(...) { args.exponent = -1.; }
+            if (args.exponent <= 0 || args.exponent > 1)
+                throw "bad exponent value: " + value;
+            ++i;
+            value = std::string { argv[i] };
+            try { args.offset = std::stod(value); } catch(...) { args.offset = -1.; }
+            if (args.offset < 0)
+                throw "bad offset value: " + value;
+        } else if (option == "--every") {
+            ++i;
+            if (i == argc)
+                throw std::string { "missing argument for `--every`" };
+            auto value = std::string { argv[i] };
+            try { args.every = std::stoll(value); } catch(...) { args.every = -1; }
+            if (args.every <= 0)
+                throw "bad every value: " + value;
+        } else if (args.alpha < 0) {
+            try { args.alpha = std::stod(option); } catch(...) { args.alpha = -1.; }
+            if (args.alpha <= 0 || args.alpha >= 1)
+                throw "bad alpha value: " + option;
+        } else if (args.path.empty()) {
+            args.path = option;
+        } else {
+            throw "unknown option: " + option;
+        }
+    }
+    if (args.alpha < 0)
+        throw std::string { "missing parameter alpha" };
+    if (args.path.empty())
+        throw std::string { "missing loss file" };
+    return args;
+}
+
+// Observateur qui écrit `<n>,<xi>,<C>` dès que le nombre de pertes lues dépasse un multiple de
+// `every` (les observateurs n'étant appelés qu'entre deux blocs, cf `approx_kernel::consume`).
+class report {
+    private:
+        long long every, next;
+
+    public:
+        explicit report(long long every) : every { every }, next { every }
+        {
+        }
+
+        auto operator ()(long long n, const detail::state<2> & state) -> bool {
+            if (every > 0 && n >= next) {
+                std::cout << n << "," << state[0] << "," << state[1] << std::endl;
+                next = (n / every + 1) * every;
+            }
+            return true;
+        }
+};
+
+// Exécute le calcul avec la suite de pas choisie par `steps::dispatch`.
+template<class Source>
+class stream_runner {
+    private:
+        const stream_args & args;
+        Source & source;
+
+    public:
+        stream_runner(const stream_args & args, Source & source) : args(args), source(source)
+        {
+        }
+
+        template<class Gamma>
+        void operator ()(const Gamma & gamma) const {
+            auto kernel = stochastic_gradient(args.alpha, 0, identity, gamma, args.avg);
+            auto observer = report { args.every };
+            auto result = kernel.consume(source, observer);
+            std::cout << result.first << "," << result.second << std::endl;
+        }
+};
+
+template<class Source>
+void run(const stream_args & args, Source & source) {
+    steps::dispatch(args.exponent, args.offset, stream_runner<Source> { args, source });
+}
+
+// Vérifie qu'une perte évaluable par blocs (cf `src/losses.hpp`) donne, lue par blocs de 100
+// pertes (taille qui n'est pas un multiple de `detail::sampler_block`), exactement le même
+// résultat que la même perte appelée une à une: chaque pas ne doit lire que le bloc courant.
+auto check_stream() -> bool {
+    auto put = losses::european_put { losses::black_scholes { 100, 0.2, 0.05, 1 }, 110, -1, 10 };
+    auto scalar = [&](double x) { return put(x); };
+
+    auto file = std::tmpfile();
+    if (file == nullptr)
+        throw std::string { "cannot create a temporary file" };
+    auto g = philox4x32 { 1 };
+    auto d = std::normal_distribution<> { };
+    for (int i = 0; i < 10000; ++i) {
+        auto x = d(g);
+        std::fwrite(&x, sizeof(double), 1, file);
+    }
+    std::fflush(file);
+
+    detail::no_observer none;
+    std::rewind(file);
+    auto batch_source = fd_losses { fileno(file), 100 };
+    auto batch = stochastic_gradient(0.95, 0, put).consume(batch_source, none);
+    std::rewind(file);
+    auto scalar_source = fd_losses { fileno(file), 100 };
+    auto one_by_one = stochastic_gradient(0.95, 0, scalar).consume(scalar_source, none);
+    std::fclose(file);
+    return batch == one_by_one;
+}
+
+auto main(int argc, char ** argv) -> int {
+    try {
+        if (argc == 2 && std::string { argv[1] } == "--check") {
+            if (!check_stream()) {
+                std::cerr << "check failed" << std::endl;
+                return 1;
+            }
+            std::cout << "ok" << std::endl;
+            return 0;
+        }
+        auto args = parse_stream_args(argc, argv);
+        if (args.path == "-") {
+            auto source = fd_losses { 0 };
+            run(args, source);
+        } else {
+            mapped_losses source { args.path };
+            run(args, source);
+        }
+    } catch (const std::string & s) {
+        std::cerr << s << std::endl;
+        return 1;
+    }
+    return 0;
+}